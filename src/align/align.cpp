@@ -367,6 +367,8 @@ void align_queries(Consumer* output_file, Search::Config& cfg)
 		delete[] i;
 	Extension::target_matrices.clear();
 	statistics.inc(Statistics::MATRIX_ADJUST_COUNT, Extension::target_matrix_count);
+	statistics.inc(Statistics::MATRIX_CACHE_HITS, ::Stats::matrix_cache_hits.exchange(0));
+	statistics.inc(Statistics::MATRIX_CACHE_MISSES, ::Stats::matrix_cache_misses.exchange(0));
 
 	if (!cfg.blocked_processing && !cfg.iterated())
 		cfg.db->end_random_access(false);
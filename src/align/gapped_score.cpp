@@ -187,10 +187,19 @@ pair<vector<Target>, Stats> align(const vector<WorkTarget> &targets, const Seque
 
 	for (int i = 0; i < (int)targets.size(); ++i) {
 		r.emplace_back(targets[i].block_id, targets[i].seq, targets[i].ungapped_score.front(), targets[i].matrix);
-		if (targets[i].done)
+		if (targets[i].done) {
 			r.back().add_hit(targets[i].hsp[0].front(), query_seq[targets[i].hsp[0].front().frame].length());
-		else
-			add_dp_targets(targets[i], i, query_seq, dp_targets, flags, hsp_values, mode, cfg);
+			continue;
+		}
+#ifdef WITH_DNA
+		Hsp hsp;
+		if (mode != Mode::GLOBAL && wfa_align(targets[i], query_seq[0], ::Stats::CBS::hauser(config.comp_based_stats) ? query_cb[0].int8.data() : nullptr, hsp, stat)) {
+			r.back().add_hit(std::move(hsp));
+			r.back().done = true;
+			continue;
+		}
+#endif
+		add_dp_targets(targets[i], i, query_seq, dp_targets, flags, hsp_values, mode, cfg);
 		if (targets[i].adjusted_matrix())
 			++cbs_targets;		
 	}
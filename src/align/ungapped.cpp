@@ -29,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../stats/hauser_correction.h"
 #include "target.h"
 #include "../dp/ungapped.h"
+#include "../dp/ungapped_simd.h"
 #include "target.h"
 #include "../data/reference.h"
 #include "../util/log_stream.h"
@@ -60,12 +61,70 @@ WorkTarget::WorkTarget(BlockId block_id, const Sequence& seq, int query_len, con
 	matrix = ::Stats::TargetMatrix(query_comp, query_len, seq);
 }
 
-WorkTarget ungapped_stage(FlatArray<SeedHit>::DataIterator begin, FlatArray<SeedHit>::DataIterator end, const Sequence *query_seq, const Bias_correction *query_cb, const ::Stats::Composition& query_comp, const int16_t** query_matrix, uint32_t block_id, Statistics& stat, const Block& targets, const Mode mode) {
-	array<vector<DiagonalSegment>, MAX_CONTEXT> diagonal_segments;
-	TaskTimer timer;
+WorkTarget::WorkTarget(BlockId block_id, const Sequence& seq, ::Stats::TargetMatrix&& matrix) :
+	block_id(block_id),
+	seq(seq),
+	matrix(std::move(matrix)),
+	done(false)
+{
+	ungapped_score.fill(0);
+}
+
+static Sequence target_seq(const Sequence* query_seq, const Block& targets, uint32_t block_id) {
 	const SequenceSet& ref_seqs = targets.seqs(), &ref_seqs_unmasked = targets.unmasked_seqs();
 	const bool masking = config.comp_based_stats == ::Stats::CBS::COMP_BASED_STATS_AND_MATRIX_ADJUST ? ::Stats::use_seg_masking(query_seq[0], ref_seqs_unmasked[block_id]) : true;
-	WorkTarget target(block_id, masking ? ref_seqs[block_id] : ref_seqs_unmasked[block_id], ::Stats::count_true_aa(query_seq[0]), query_comp, query_matrix);
+	return masking ? ref_seqs[block_id] : ref_seqs_unmasked[block_id];
+}
+
+// Extends the seed hits of one frame, sorted by diagonal. A hit is skipped if the previous extension on its diagonal
+// covers it. Each round extends the first remaining hit of every diagonal, so that distinct diagonals are extended in
+// parallel.
+static void extend_hits(FlatArray<SeedHit>::DataIterator begin, FlatArray<SeedHit>::DataIterator end, const Sequence& query, const int8_t* cbs, const Sequence& target, bool count_identities, vector<DiagonalSegment>& out) {
+	struct Run {
+		ptrdiff_t next, end;
+		Loc last_end;
+	};
+	const ptrdiff_t n = end - begin;
+	vector<Run> runs;
+	for (ptrdiff_t i = 0; i < n;) {
+		ptrdiff_t j = i + 1;
+		while (j < n && begin[j].diag() == begin[i].diag())
+			++j;
+		runs.push_back({ i, j, INT_MIN });
+		i = j;
+	}
+	vector<DiagonalSegment> segments(n);
+	vector<Loc> qa, sa;
+	vector<DiagonalSegment> ext;
+	while (!runs.empty()) {
+		std::sort(runs.begin(), runs.end(), [begin](const Run& a, const Run& b) { return begin[a.next].i < begin[b.next].i; });
+		qa.clear();
+		sa.clear();
+		for (const Run& r : runs) {
+			qa.push_back(begin[r.next].i);
+			sa.push_back(begin[r.next].j);
+		}
+		ext.resize(runs.size());
+		DP::xdrop_ungapped(query, cbs, target, qa.data(), sa.data(), (int)runs.size(), count_identities, ext.data());
+		for (size_t k = 0; k < runs.size(); ++k) {
+			Run& r = runs[k];
+			segments[r.next] = ext[k];
+			if (ext[k].score > 0)
+				r.last_end = ext[k].subject_end();
+			while (++r.next < r.end && r.last_end >= begin[r.next].j);
+		}
+		runs.erase(std::remove_if(runs.begin(), runs.end(), [](const Run& r) { return r.next == r.end; }), runs.end());
+	}
+	for (const DiagonalSegment& d : segments)
+		if (d.score > 0)
+			out.push_back(d);
+}
+
+WorkTarget ungapped_stage(FlatArray<SeedHit>::DataIterator begin, FlatArray<SeedHit>::DataIterator end, const Sequence *query_seq, const Bias_correction *query_cb, const ::Stats::Composition& query_comp, const int16_t** query_matrix, uint32_t block_id, Statistics& stat, const Block& targets, const Mode mode, ::Stats::TargetMatrix* matrix = nullptr) {
+	array<vector<DiagonalSegment>, MAX_CONTEXT> diagonal_segments;
+	TaskTimer timer;
+	WorkTarget target = matrix ? WorkTarget(block_id, target_seq(query_seq, targets, block_id), std::move(*matrix))
+		: WorkTarget(block_id, target_seq(query_seq, targets, block_id), ::Stats::count_true_aa(query_seq[0]), query_comp, query_matrix);
 	stat.inc(Statistics::TIME_MATRIX_ADJUST, timer.microseconds());
 	if (target.adjusted_matrix())
 		stat.inc(Statistics::MATRIX_ADJUST_COUNT);
@@ -82,15 +141,23 @@ WorkTarget ungapped_stage(FlatArray<SeedHit>::DataIterator begin, FlatArray<Seed
 	}
 	std::sort(begin, end);
 	const bool with_diag_filter = (config.hamming_ext || config.diag_filter_cov > 0 || config.diag_filter_id > 0) && !config.mutual_cover.present();
-	for (FlatArray<SeedHit>::DataIterator hit = begin; hit < end; ++hit) {
-		const auto f = hit->frame;
-		target.ungapped_score[f] = std::max(target.ungapped_score[f], hit->score);
-		if (!diagonal_segments[f].empty() && diagonal_segments[f].back().diag() == hit->diag() && diagonal_segments[f].back().subject_end() >= hit->j)
-			continue;
-		const int8_t* cbs = ::Stats::CBS::hauser(config.comp_based_stats) ? query_cb[f].int8.data() : nullptr;
-		const DiagonalSegment d = xdrop_ungapped(query_seq[f], cbs, target.seq, hit->i, hit->j, with_diag_filter);
-		if (d.score > 0)
-			diagonal_segments[f].push_back(d);
+	if (align_mode.query_contexts == 1) {
+		for (FlatArray<SeedHit>::DataIterator hit = begin; hit < end; ++hit)
+			target.ungapped_score[0] = std::max(target.ungapped_score[0], hit->score);
+		const int8_t* cbs = ::Stats::CBS::hauser(config.comp_based_stats) ? query_cb[0].int8.data() : nullptr;
+		extend_hits(begin, end, query_seq[0], cbs, target.seq, with_diag_filter, diagonal_segments[0]);
+	}
+	else {
+		for (FlatArray<SeedHit>::DataIterator hit = begin; hit < end; ++hit) {
+			const auto f = hit->frame;
+			target.ungapped_score[f] = std::max(target.ungapped_score[f], hit->score);
+			if (!diagonal_segments[f].empty() && diagonal_segments[f].back().diag() == hit->diag() && diagonal_segments[f].back().subject_end() >= hit->j)
+				continue;
+			const int8_t* cbs = ::Stats::CBS::hauser(config.comp_based_stats) ? query_cb[f].int8.data() : nullptr;
+			const DiagonalSegment d = xdrop_ungapped(query_seq[f], cbs, target.seq, hit->i, hit->j, with_diag_filter);
+			if (d.score > 0)
+				diagonal_segments[f].push_back(d);
+		}
 	}
 
 	if (with_diag_filter) {
@@ -138,11 +205,21 @@ vector<WorkTarget> ungapped_stage(const Sequence *query_seq, const Bias_correcti
 		Util::Parallel::scheduled_thread_pool_auto(config.threads_, n, ungapped_stage_worker, query_seq, query_cb, &query_comp, seed_hits, target_block_ids, &targets, &mtx, &stat, &target_block, mode);
 	}
 	else {
+		vector<::Stats::TargetMatrix> matrices;
+		if (::Stats::CBS::matrix_adjust(config.comp_based_stats) && n > 1) {
+			TaskTimer timer;
+			vector<Sequence> seqs;
+			seqs.reserve(n);
+			for (int64_t i = 0; i < n; ++i)
+				seqs.push_back(target_seq(query_seq, target_block, target_block_ids[i]));
+			matrices = ::Stats::TargetMatrix::batch(query_comp, ::Stats::count_true_aa(query_seq[0]), seqs);
+			stat.inc(Statistics::TIME_MATRIX_ADJUST, timer.microseconds());
+		}
 		for (int64_t i = 0; i < n; ++i) {
 			/*const double len_ratio = query_seq->length_ratio(target_block.seqs()[target_block_ids[i]]);
 			if (len_ratio < config.min_length_ratio)
 				continue;*/
-			targets.push_back(ungapped_stage(seed_hits.begin(i), seed_hits.end(i), query_seq, query_cb, query_comp, &query_matrix, target_block_ids[i], stat, target_block, mode));
+			targets.push_back(ungapped_stage(seed_hits.begin(i), seed_hits.end(i), query_seq, query_cb, query_comp, &query_matrix, target_block_ids[i], stat, target_block, mode, matrices.empty() ? nullptr : &matrices[i]));
 			for (const ApproxHsp& hsp : targets.back().hsp[0]) {
 				Geo::assert_diag_bounds(hsp.d_max, query_seq[0].length(), targets.back().seq.length());
 				Geo::assert_diag_bounds(hsp.d_min, query_seq[0].length(), targets.back().seq.length());
@@ -0,0 +1,225 @@
+/****
+DIAMOND protein aligner
+Copyright (C) 2022 Max Planck Society for the Advancement of Science e.V.
+
+Code developed by Benjamin Buchfink <benjamin.buchfink@tue.mpg.de>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****/
+
+#include <memory>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <math.h>
+#include "bindings/cpp/WFAligner.hpp"
+#include "target.h"
+#include "../basic/config.h"
+#include "../stats/score_matrix.h"
+
+using std::vector;
+using std::pair;
+
+namespace Extension {
+
+static const int WFA_CUTOFF_STEPS = 10;
+
+// Gap-affine penalties for the wavefront aligner, derived from the average match score a and mismatch score -b of the
+// score matrix. Scores are converted to penalties with a match penalty of 0, which requires scaling them by 2.
+struct WfaPenalties {
+	WfaPenalties() {
+		double match = 0.0, mismatch = 0.0;
+		for (int i = 0; i < 20; ++i)
+			for (int j = 0; j < 20; ++j)
+				(i == j ? match : mismatch) += score_matrix(Letter(i), Letter(j));
+		const int a = std::max((int)lround(match / 20), 1), b = std::max((int)lround(-mismatch / 380), 0);
+		this->mismatch = 2 * (a + b);
+		gap_open = 2 * score_matrix.gap_open();
+		gap_extend = 2 * score_matrix.gap_extend() + a;
+	}
+	int mismatch, gap_open, gap_extend;
+};
+
+struct WfaSequences {
+	const Letter* target, * query;
+	int dir;
+};
+
+static int wfa_match(int v, int h, void* args) {
+	const WfaSequences& s = *(const WfaSequences*)args;
+	return letter_mask(s.target[s.dir * v]) == letter_mask(s.query[s.dir * h]);
+}
+
+// Extends from the anchor into direction dir, appending the CIGAR operations in the order of the extension.
+static bool extend(wfa::WFAligner& aligner, const Letter* target, Loc tlen, const Letter* query, Loc qlen, int dir, vector<pair<char, Loc>>& ops) {
+	if (tlen == 0 || qlen == 0)
+		return true;
+	WfaSequences s{ target, query, dir };
+	if (aligner.alignExtension(wfa_match, &s, tlen, qlen) < 0)
+		return false;
+	const std::string cigar = aligner.getCIGAR(false);
+	Loc n = 0;
+	for (char c : cigar) {
+		if (isdigit(c)) {
+			n = n * 10 + (c - '0');
+			continue;
+		}
+		if (c == '=' || c == 'X')
+			c = 'M';
+		else if (c != 'M' && c != 'I' && c != 'D')
+			return false;
+		ops.emplace_back(c, n);
+		n = 0;
+	}
+	return true;
+}
+
+static wfa::WFAligner& aligner() {
+	thread_local std::unique_ptr<wfa::WFAlignerGapAffine> aligner;
+	if (!aligner) {
+		static const WfaPenalties p;
+		aligner.reset(new wfa::WFAlignerGapAffine(0, p.mismatch, p.gap_open, p.gap_extend, wfa::WFAligner::Alignment, wfa::WFAligner::MemoryLow));
+		aligner->setHeuristicNone();
+		aligner->setHeuristicZDrop(2 * score_matrix.rawscore(config.gapped_xdrop), WFA_CUTOFF_STEPS);
+	}
+	return *aligner;
+}
+
+bool wfa_align(const WorkTarget& target, const Sequence& query, const int8_t* query_cbs, Hsp& out, Statistics& stat) {
+	if (config.wfa_min_id <= 0.0 || align_mode.query_translated || target.adjusted_matrix() || target.hsp[0].empty() || config.max_hsps != 1)
+		return false;
+	const ApproxHsp& hsp = *std::max_element(target.hsp[0].begin(), target.hsp[0].end(), [](const ApproxHsp& a, const ApproxHsp& b) { return a.score < b.score; });
+	const DiagonalSegment& d = hsp.max_diag;
+	if (d.len <= 0)
+		return false;
+	const Sequence& seq = target.seq;
+	Loc ident = 0;
+	for (Loc k = 0; k < d.len; ++k)
+		if (letter_mask(query[d.i + k]) == letter_mask(seq[d.j + k]))
+			++ident;
+	if (ident * 100.0 < config.wfa_min_id * d.len)
+		return false;
+
+	vector<pair<char, Loc>> left, right;
+	if (!extend(aligner(), seq.data() + d.j - 1, d.j, query.data() + d.i - 1, d.i, -1, left)
+		|| !extend(aligner(), seq.data() + d.subject_end(), seq.length() - d.subject_end(), query.data() + d.query_end(), query.length() - d.query_end(), 1, right)) {
+		stat.inc(Statistics::EXT_WFA_FALLBACK);
+		return false;
+	}
+	vector<pair<char, Loc>> ops(left.rbegin(), left.rend());
+	ops.emplace_back('M', d.len);
+	ops.insert(ops.end(), right.begin(), right.end());
+	Loc i0 = d.i, j0 = d.j;
+	for (const pair<char, Loc>& op : left) {
+		if (op.first != 'D')
+			i0 -= op.second;
+		if (op.first != 'I')
+			j0 -= op.second;
+	}
+
+	// Rescore the path with the score matrix and clip it to its maximal scoring part.
+	const int go = score_matrix.gap_open(), ge = score_matrix.gap_extend();
+	int score = 0, min_score = 0, best = 0;
+	Loc i = i0, j = j0, min_i = i0, min_j = j0, begin_i = i0, begin_j = j0, end_i = i0, end_j = j0;
+	for (const pair<char, Loc>& op : ops) {
+		if (op.first == 'M') {
+			for (Loc k = 0; k < op.second; ++k) {
+				score += score_matrix(query[i], seq[j]) + (query_cbs ? query_cbs[i] : 0);
+				++i;
+				++j;
+				if (score < min_score) {
+					min_score = score;
+					min_i = i;
+					min_j = j;
+				}
+				else if (score - min_score > best) {
+					best = score - min_score;
+					begin_i = min_i;
+					begin_j = min_j;
+					end_i = i;
+					end_j = j;
+				}
+			}
+			continue;
+		}
+		score -= go + op.second * ge;
+		(op.first == 'I' ? i : j) += op.second;
+		if (score < min_score) {
+			min_score = score;
+			min_i = i;
+			min_j = j;
+		}
+	}
+
+	const Loc path_end_i = i, path_end_j = j;
+	const double evalue = score_matrix.evalue(best, query.length(), seq.length());
+	if (best < hsp.score || evalue > config.max_evalue) {
+		stat.inc(Statistics::EXT_WFA_FALLBACK);
+		return false;
+	}
+
+	out = Hsp(true);
+	out.score = best;
+	out.evalue = evalue;
+	out.bit_score = score_matrix.bitscore(best);
+	out.corrected_bit_score = score_matrix.bitscore_corrected(best, query.length(), seq.length());
+	out.frame = 0;
+	out.query_range = Interval(begin_i, end_i);
+	out.subject_range = Interval(begin_j, end_j);
+	int d_min = begin_i - begin_j, d_max = d_min;
+	i = path_end_i;
+	j = path_end_j;
+	for (auto it = ops.rbegin(); it != ops.rend(); ++it) {
+		const Loc n = it->second;
+		if (it->first == 'M') {
+			for (Loc k = 0; k < n; ++k) {
+				--i;
+				--j;
+				if (i < begin_i || i >= end_i)
+					continue;
+				out.push_match(query[i], seq[j], score_matrix(query[i], seq[j]) > 0);
+			}
+		}
+		else if (it->first == 'I') {
+			if (i <= end_i && i - n >= begin_i)
+				out.push_gap(op_insertion, n, seq.data() + j);
+			i -= n;
+		}
+		else {
+			if (j <= end_j && j - n >= begin_j)
+				out.push_gap(op_deletion, n, seq.data() + j - 1);
+			j -= n;
+		}
+		if (i >= begin_i && j >= begin_j && i <= end_i && j <= end_j) {
+			d_min = std::min(d_min, i - j);
+			d_max = std::max(d_max, i - j);
+		}
+	}
+	out.d_begin = d_min;
+	out.d_end = d_max + 1;
+	out.transcript.reverse();
+	out.transcript.push_terminator();
+	out.target_seq = seq;
+	out.query_source_range = out.query_range;
+	out.subject_source_range = out.subject_range;
+	out.approx_id = out.approx_id_percent(query, seq);
+	if (out.id_percent() < config.wfa_min_id) {
+		stat.inc(Statistics::EXT_WFA_FALLBACK);
+		return false;
+	}
+	stat.inc(Statistics::EXT_WFA);
+	return true;
+}
+
+}
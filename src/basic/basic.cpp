@@ -201,11 +201,16 @@ void Statistics::print() const
 	if (data_[MASKED_LAZY])
 		log_stream << "Lazy maskings         = " << data_[MASKED_LAZY] << endl;
 	log_stream << "Matrix adjusts        = " << data_[MATRIX_ADJUST_COUNT] << endl;
+	if (data_[MATRIX_CACHE_HITS] + data_[MATRIX_CACHE_MISSES])
+		log_stream << "Matrix cache hits     = " << data_[MATRIX_CACHE_HITS] << '/' << data_[MATRIX_CACHE_HITS] + data_[MATRIX_CACHE_MISSES] << endl;
 	log_stream << "Extensions (8 bit)    = " << data_[EXT8] << endl;
 	log_stream << "Extensions (16 bit)   = " << data_[EXT16] << endl;
 	log_stream << "Extensions (32 bit)   = " << data_[EXT32] << endl;
 	log_stream << "Overflows (8 bit)     = " << data_[EXT_OVERFLOW_8] << endl;
 	log_stream << "Wasted (16 bit)       = " << data_[EXT_WASTED_16] << endl;
+	log_stream << "Promotions (8 bit)    = " << data_[EXT_PROMOTED_8] << endl;
+	if (data_[EXT_WFA] + data_[EXT_WFA_FALLBACK])
+		log_stream << "Extensions (WFA)      = " << data_[EXT_WFA] << " (" << data_[EXT_WFA_FALLBACK] << " fallbacks)" << endl;
 	log_stream << "Effort (Extension)    = " << 2 * data_[EXT16] + data_[EXT8] << endl;
 	log_stream << "Effort (Cells)        = " << 2 * data_[DP_CELLS_16] + data_[DP_CELLS_8] << endl;
 	log_stream << "Cells (8 bit)         = " << data_[DP_CELLS_8] << endl;
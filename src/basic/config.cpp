@@ -231,7 +231,8 @@ Config::Config(int argc, const char **argv, bool check_io, CommandLineParser& pa
     string dbstring;
 	auto& makedb_opt = parser.add_group("Makedb options", { makedb, MERGE_DAA });
 	makedb_opt.add()
-		("in", 0, "input reference file in FASTA format/input DAA files for merge-daa", input_ref_file);
+		("in", 0, "input reference file in FASTA format/input DAA files for merge-daa", input_ref_file)
+		("pack-letters", 0, "store sequence letters with 5 bits per letter (protein databases)", pack_letters);
 
 	auto& makedb_tax_opt = parser.add_group("Makedb/taxon options", { makedb });
 	makedb_tax_opt.add()
@@ -269,7 +270,8 @@ Config::Config(int argc, const char **argv, bool check_io, CommandLineParser& pa
 		("more-sensitive", 0, "enable more sensitive mode", mode_more_sensitive)
 		("very-sensitive", 0, "enable very sensitive mode", mode_very_sensitive)
 		("ultra-sensitive", 0, "enable ultra sensitive mode", mode_ultra_sensitive)
-		("shapes", 's', "number of seed shapes (default=all available)", shapes);
+		("shapes", 's', "number of seed shapes (default=all available)", shapes)
+		("seed-arrays", 0, "write/use precomputed reference seed arrays per block (see makeidx)", seed_arrays);
 
 	auto& aligner = parser.add_group("Aligner options", { blastp, blastx });
 	aligner.add()
@@ -406,6 +408,7 @@ Config::Config(int argc, const char **argv, bool check_io, CommandLineParser& pa
 	advanced_gen.add()
 		("file-buffer-size", 0, "file buffer size in bytes (default=67108864)", file_buffer_size, (size_t)67108864)
 		("no-unlink", 0, "Do not unlink temporary files.", no_unlink)
+		("mmap-db", 0, "Memory-map .dmnd database files for loading sequences", mmap_db)
 		("ignore-warnings", 0, "Ignore warnings", ignore_warnings)
 		("no-parse-seqids", 0, "Print raw seqids without parsing", no_parse_seqids);
 
@@ -428,11 +431,15 @@ Config::Config(int argc, const char **argv, bool check_io, CommandLineParser& pa
 		("id2", 0, "minimum number of identities for stage 1 hit", min_identities_)
 		("linsearch", 0, "only consider seed hits against longest target for identical seeds", linsearch)
 		("lin-stage1", 0, "only consider seed hits against longest query for identical seeds", lin_stage1)
+		("reduced-fp", 0, "use reduced alphabet fingerprints for the stage 1 hit filter", reduced_fp)
+		("reduced-fp-id", 0, "minimum number of reduced alphabet identities for stage 1 hit (default=id2)", reduced_fp_id)
 		("xdrop", 'x', "xdrop for ungapped alignment", ungapped_xdrop, 12.3)
 		("gapped-filter-evalue", 0, "E-value threshold for gapped filter (auto)", gapped_filter_evalue_, -1.0)
 		("band", 0, "band for dynamic programming computation", padding)
 		("shape-mask", 0, "seed shapes", shape_mask)
 		("multiprocessing", 0, "enable distributed-memory parallel processing", multiprocessing)
+		("query-batch-size", 0, "number of query letters per block, independent of the block size (default=block size)", query_batch_size)
+		("query-batch-latency", 0, "close a query block after this many milliseconds to report streamed input early", query_batch_latency)
 		("mp-init", 0, "initialize multiprocessing run", mp_init)
 		("mp-recover", 0, "enable continuation of interrupted multiprocessing run", mp_recover)
 		("mp-query-chunk", 0, "process only a single query chunk as specified", mp_query_chunk, -1)
@@ -577,9 +584,13 @@ Config::Config(int argc, const char **argv, bool check_io, CommandLineParser& pa
 		("no-logfile", 0, "", no_logfile)
 		("band-bin", 0, "", band_bin, 24)
 		("col-bin", 0, "", col_bin, 400)
+		("swipe-xdrop", 0, "", swipe_xdrop)
 		("self", 0, "", self)
 		("trace-pt-fetch-size", 0, "", trace_pt_fetch_size, (int64_t)10e9)
 		("tile-size", 0, "", tile_size, (uint32_t)1024)
+		("numa", 0, "", numa)
+		("pipeline", 0, "", pipeline)
+		("auto-tune", 0, "", auto_tune)
 		("short-query-ungapped-bitscore", 0, "", short_query_ungapped_bitscore, 25.0)
 		("short-query-max-len", 0, "", short_query_max_len, 60)
 		("gapped-filter-evalue1", 0, "", gapped_filter_evalue1, 2000.0)
@@ -609,11 +620,15 @@ Config::Config(int argc, const char **argv, bool check_io, CommandLineParser& pa
 		("cbs-angle", 0, "", cbs_angle, -1.0)
 		("cbs-err-tolerance", 0, "", cbs_err_tolerance, 0.00000001)
 		("cbs-it-limit", 0, "", cbs_it_limit, 2000)
+		("cbs-cache", 0, "", cbs_cache, (size_t)0)
+		("cbs-cache-tolerance", 0, "", cbs_cache_tolerance, 0.0)
 		("hash_join_swap", 0, "", hash_join_swap)
 		("deque_bucket_size", 0, "", deque_bucket_size, (size_t)524288)
 		("query-match-distance-threshold", 0, "", query_match_distance_threshold, -1.0)
 		("length-ratio-threshold", 0, "", length_ratio_threshold, -1.0)
 		("max-swipe-dp", 0, "", max_swipe_dp, (int64_t)1000000)
+		("max-trace-pool", 0, "", max_trace_pool, (int64_t)268435456)
+		("wfa-min-id", 0, "", wfa_min_id, 0.0)
 		("short-seqids", 0, "", short_seqids)
 		("no-reextend", 0, "", no_reextend)
 		("no-reorder", 0, "", no_reorder)
@@ -736,6 +751,11 @@ Config::Config(int argc, const char **argv, bool check_io, CommandLineParser& pa
 	if (command == blastx && !Stats::CBS::support_translated(comp_based_stats))
 		throw std::runtime_error("This mode of composition based stats is not supported for translated searches.");
 
+#ifndef WITH_DNA
+	if (wfa_min_id > 0.0)
+		throw std::runtime_error("Option --wfa-min-id requires a build with WITH_DNA enabled.");
+#endif
+
     if (check_io) {
 		switch (command) {
 		case Config::makedb: {
@@ -810,6 +830,9 @@ Config::Config(int argc, const char **argv, bool check_io, CommandLineParser& pa
 	verbose_stream << "Assertions enabled." << endl;
 #endif
 	set_option(threads_, (int)std::thread::hardware_concurrency());
+	set_numa_binding(numa);
+	if (numa)
+		verbose_stream << "NUMA nodes: " << numa_node_count() << endl;
 
 	switch (command) {
 	case Config::makedb:
@@ -849,6 +872,7 @@ Config::Config(int argc, const char **argv, bool check_io, CommandLineParser& pa
 	case Config::CLUSTER_REALIGN:
 	case Config::RECLUSTER:
 	case Config::MODEL_SEQS:
+	case Config::makeidx:
 		if (frame_shift != 0 && command == Config::blastp)
 			throw std::runtime_error("Frameshift alignments are only supported for translated searches.");
 		if (query_range_culling && frame_shift == 0)
@@ -225,10 +225,21 @@ struct Config
 	bool no_logfile;
 	int band_bin;
 	int col_bin;
+	int swipe_xdrop;
 	size_t file_buffer_size;
+	bool mmap_db;
+	bool pack_letters;
 	bool self;
 	int64_t trace_pt_fetch_size;
 	uint32_t tile_size;
+	bool reduced_fp;
+	bool seed_arrays;
+	int64_t query_batch_size;
+	int query_batch_latency;
+	bool numa;
+	bool pipeline;
+	bool auto_tune;
+	unsigned reduced_fp_id;
 	double short_query_ungapped_bitscore;
 	int short_query_max_len;
 	double gapped_filter_evalue1;
@@ -274,6 +285,10 @@ struct Config
 	double log_evalue_scale;
 	double ungapped_evalue_short_;
 	int64_t max_swipe_dp;
+	int64_t max_trace_pool;
+	size_t cbs_cache;
+	double cbs_cache_tolerance;
+	double wfa_min_id;
 	std::string seqidlist;
 	bool skip_missing_seqids;
 	Option<string_vector> iterate;
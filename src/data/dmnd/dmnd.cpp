@@ -40,6 +40,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../../util/util.h"
 #include "../fasta/fasta_file.h"
 #include "../../util/sequence/sequence.h"
+#include "../../lib/mio/mmap.hpp"
+#include "../../util/sequence/packed.h"
 
 using std::tuple;
 using std::string;
@@ -52,6 +54,10 @@ using std::runtime_error;
 const char* DatabaseFile::FILE_EXTENSION = ".dmnd";
 const uint32_t ReferenceHeader::current_db_version_prot = 3;
 const uint32_t ReferenceHeader::current_db_version_nucl = 4;
+// Version 5 protein databases (makedb --pack-letters) store each record as the varint sequence length, the 5-bit packed
+// letters, the runs of masked letters (Util::Seq::pack_mask) and the null terminated id. The third field of the
+// position array entries, which is zero in earlier versions, holds the size of the masking runs.
+const uint32_t ReferenceHeader::packed_db_version_prot = 5;
 
 Serializer& operator<<(Serializer &s, const ReferenceHeader2 &h)
 {
@@ -100,13 +106,12 @@ Serializer& operator<<(Serializer& file, const ReferenceHeader& h)
 }
 
 InputFile& operator>>(InputFile& file, SequenceFile::SeqInfo& r) {
-	uint32_t p;
-	file >> r.pos >> r.seq_len >> p;
+	file >> r.pos >> r.seq_len >> r.mask_bytes;
 	return file;
 }
 
 Serializer& operator<<(Serializer& file, const SequenceFile::SeqInfo& r) {
-	file << r.pos << r.seq_len << (uint32_t)0;
+	file << r.pos << r.seq_len << r.mask_bytes;
 	return file;
 }
 
@@ -124,11 +129,12 @@ void DatabaseFile::putback_seqinfo() {
 void DatabaseFile::init(Flags flags)
 {
 	read_header(*this, ref_header);
+	packed_ = ref_header.db_version == ReferenceHeader::packed_db_version_prot;
 	if (flag_any(flags, Flags::NO_COMPATIBILITY_CHECK))
 		return;
 	if (ref_header.build < min_build_required || ref_header.db_version < MIN_DB_VERSION)
 		throw std::runtime_error("Database was built with an older version of Diamond and is incompatible.");
-	if (ref_header.db_version > std::max(ReferenceHeader::current_db_version_prot , ReferenceHeader::current_db_version_nucl))
+	if (ref_header.db_version > std::max({ ReferenceHeader::current_db_version_prot, ReferenceHeader::current_db_version_nucl, ReferenceHeader::packed_db_version_prot }))
 		throw std::runtime_error("Database was built with a newer version of Diamond and is incompatible.");
 	if (ref_header.sequences == 0)
 		throw std::runtime_error("Incomplete database file. Database building did not complete successfully.");
@@ -139,9 +145,13 @@ void DatabaseFile::init(Flags flags)
 DatabaseFile::DatabaseFile(const string &input_file, Metadata metadata, Flags flags, const ValueTraits& value_traits):
 	SequenceFile(SequenceFile::Type::DMND, Alphabet::STD, flags, FormatFlags::DICT_LENGTHS | FormatFlags::DICT_SEQIDS | FormatFlags::SEEKABLE | FormatFlags::LENGTH_LOOKUP, value_traits),
 	InputFile(auto_append_extension_if_exists(input_file, FILE_EXTENSION), InputFile::BUFFERED),
-	temporary(false)
+	temporary(false),
+	mmap_pos_(0),
+	packed_(false)
 {
 	init(flags);
+	if (config.mmap_db)
+		init_mmap();
 
 	vector<string> e;
 	if (flag_any(metadata, Metadata::TAXON_MAPPING) && !has_taxon_id_lists())
@@ -174,7 +184,9 @@ DatabaseFile::DatabaseFile(const string &input_file, Metadata metadata, Flags fl
 DatabaseFile::DatabaseFile(TempFile &tmp_file, const ValueTraits& value_traits):
 	SequenceFile(SequenceFile::Type::DMND, Alphabet::STD, Flags::NONE, FormatFlags::DICT_LENGTHS | FormatFlags::DICT_SEQIDS | FormatFlags::SEEKABLE | FormatFlags::LENGTH_LOOKUP, value_traits),
 	InputFile(tmp_file, 0),
-	temporary(true)
+	temporary(true),
+	mmap_pos_(0),
+	packed_(false)
 {
 	init();
 }
@@ -183,7 +195,21 @@ int64_t DatabaseFile::file_count() const {
 	return 1;
 }
 
+void DatabaseFile::init_mmap() {
+	std::error_code err;
+	mmap_.reset(new mio::mmap_source());
+	mmap_->map(InputFile::file_name, err);
+	uint64_t magic_number = 0;
+	if (!err && mmap_->length() >= sizeof(magic_number))
+		memcpy(&magic_number, mmap_->data(), sizeof(magic_number));
+	if (magic_number != ReferenceHeader().magic_number) {
+		log_stream << "Memory mapping of database file failed, falling back to buffered reads: " << InputFile::file_name << endl;
+		mmap_.reset();
+	}
+}
+
 void DatabaseFile::close() {
+	mmap_.reset();
 	if (temporary)
 		InputFile::close_and_delete();
 	else
@@ -223,6 +249,20 @@ static void push_seq(const Sequence &seq, const char *id, size_t id_len, uint64_
 	offset += seq.length() + id_len + 3;
 }
 
+static void push_packed_seq(const Sequence& seq, const char* id, size_t id_len, uint64_t& offset, vector<SequenceFile::SeqInfo>& pos_array, OutputFile& out, size_t& letters, size_t& n_seqs, vector<char>& buf)
+{
+	buf.clear();
+	Util::Seq::pack(seq.data(), seq.length(), buf);
+	const size_t packed = buf.size();
+	Util::Seq::pack_mask(seq.data(), seq.length(), buf);
+	pos_array.emplace_back(offset, seq.length(), uint32_t(buf.size() - packed));
+	out.write(buf.data(), buf.size());
+	out.write(id, id_len + 1);
+	letters += seq.length();
+	++n_seqs;
+	offset += buf.size() + id_len + 1;
+}
+
 void DatabaseFile::make_db()
 {
 	config.file_buffer_size = 4 * MEGABYTES;
@@ -255,10 +295,16 @@ void DatabaseFile::make_db()
         header.db_version = ReferenceHeader::current_db_version_nucl;
         flags |= SequenceFile::LoadFlags::DNA_PRESERVATION;
     }
+	if (config.pack_letters) {
+		if (config.dbtype != SequenceType::amino_acid)
+			throw std::runtime_error("Option --pack-letters is only supported for protein databases.");
+		header.db_version = ReferenceHeader::packed_db_version_prot;
+	}
 
     Block* block;
 	const FASTA_format format;
 	vector<SeqInfo> pos_array;
+	vector<char> packed_buf;
 	ExternalSorter<pair<string, OId>> accessions;
 	AccessionParsing acc_stats;
 	try {
@@ -281,7 +327,10 @@ void DatabaseFile::make_db()
 				Sequence seq = block->seqs()[i];
 				if (seq.length() == 0)
 					throw std::runtime_error("File format error: sequence of length 0 at line " + std::to_string(db_file.line_count()));
-				push_seq(seq, block->ids()[i], block->ids().length(i), offset, pos_array, *out, letters, n_seqs);
+				if (config.pack_letters)
+					push_packed_seq(seq, block->ids()[i], block->ids().length(i), offset, pos_array, *out, letters, n_seqs, packed_buf);
+				else
+					push_seq(seq, block->ids()[i], block->ids().length(i), offset, pos_array, *out, letters, n_seqs);
 			}
 			if (!config.prot_accession2taxid.empty()) {
 				timer.go("Writing accessions");
@@ -379,19 +428,44 @@ void DatabaseFile::init_seq_access() {
 	seek(sizeof(ReferenceHeader) + sizeof(ReferenceHeader2) + 8);
 }
 
+void DatabaseFile::read_packed_seq(vector<Letter>& seq) {
+	uint32_t len;
+	read_varint(*this, len);
+	const size_t n = Util::Seq::packed_size(len);
+	packed_buf_.resize(n);
+	if (read(packed_buf_.data(), n) != n)
+		throw std::runtime_error("Unexpected end of file.");
+	seq.resize(len);
+	Util::Seq::unpack(packed_buf_.data(), len, seq.data());
+	Util::Seq::unpack_mask(*this, seq.data());
+}
+
 bool DatabaseFile::read_seq(vector<Letter>& seq, string &id, std::vector<char>* quals)
 {
-	char c;
-	read(&c, 1);
 	seq.clear();
 	id.clear();
-	read_to(std::back_inserter(seq), '\xff');
+	if (packed_)
+		read_packed_seq(seq);
+	else {
+		char c;
+		read(&c, 1);
+		read_to(std::back_inserter(seq), '\xff');
+	}
 	read_to(std::back_inserter(id), '\0');
 	return false;
 }
 
 void DatabaseFile::skip_seq()
 {
+	if (packed_) {
+		uint32_t len;
+		read_varint(*this, len);
+		seek_forward(Util::Seq::packed_size(len));
+		Util::Seq::skip_mask(*this);
+		if (!seek_forward('\0'))
+			throw std::runtime_error("Unexpected end of file.");
+		return;
+	}
 	char c;
 	if(read(&c, 1) != 1)
 		throw std::runtime_error("Unexpected end of file.");
@@ -517,26 +591,90 @@ void DatabaseFile::seek_chunk(const Chunk& chunk) {
 }
 
 size_t DatabaseFile::id_len(const SeqInfo& seq_info, const SeqInfo& seq_info_next) {
+	if (packed_)
+		return seq_info_next.pos - seq_info.pos - varint_size(seq_info.seq_len) - Util::Seq::packed_size(seq_info.seq_len) - seq_info.mask_bytes - 1;
 	return seq_info_next.pos - seq_info.pos - seq_info.seq_len - 3;
 }
 
 void DatabaseFile::seek_offset(size_t p) {
 	seek(p);
+	mmap_pos_ = p;
+}
+
+namespace {
+
+struct MemoryReader {
+	template<typename T>
+	void read(T& x) {
+		if (end - ptr < (ptrdiff_t)sizeof(T))
+			throw std::runtime_error("Unexpected end of file.");
+		memcpy(&x, ptr, sizeof(T));
+		ptr += sizeof(T);
+	}
+	const char* ptr, * end;
+};
+
 }
 
 void DatabaseFile::read_seq_data(Letter* dst, size_t len, size_t& pos, bool seek) {
-	if (seek)
-		this->seek(pos);
-	read(dst - 1, len + 2);
+	if (packed_) {
+		const size_t l = varint_size((uint32_t)len), n = l + Util::Seq::packed_size(len);
+		if (mmap_) {
+			if (seek)
+				mmap_pos_ = pos;
+			if (mmap_pos_ + n > mmap_->length())
+				throw std::runtime_error("Unexpected end of file.");
+			Util::Seq::unpack(mmap_->data() + mmap_pos_ + l, len, dst);
+			MemoryReader in{ mmap_->data() + mmap_pos_ + n, mmap_->data() + mmap_->length() };
+			Util::Seq::unpack_mask(in, dst);
+			mmap_pos_ = in.ptr - mmap_->data();
+		}
+		else {
+			if (seek)
+				this->seek(pos);
+			packed_buf_.resize(n);
+			if (read(packed_buf_.data(), n) != n)
+				throw std::runtime_error("Unexpected end of file.");
+			Util::Seq::unpack(packed_buf_.data() + l, len, dst);
+			Util::Seq::unpack_mask(*this, dst);
+		}
+	}
+	else if (mmap_) {
+		if (seek)
+			mmap_pos_ = pos;
+		if (mmap_pos_ + len + 2 > mmap_->length())
+			throw std::runtime_error("Unexpected end of file.");
+		memcpy(dst, mmap_->data() + mmap_pos_ + 1, len);
+		mmap_pos_ += len + 2;
+	}
+	else {
+		if (seek)
+			this->seek(pos);
+		read(dst - 1, len + 2);
+	}
 	*(dst - 1) = Sequence::DELIMITER;
 	*(dst + len) = Sequence::DELIMITER;
 }
 
 void DatabaseFile::read_id_data(const int64_t oid, char* dst, size_t len) {
+	if (mmap_) {
+		if (mmap_pos_ + len + 1 > mmap_->length())
+			throw std::runtime_error("Unexpected end of file.");
+		memcpy(dst, mmap_->data() + mmap_pos_, len + 1);
+		mmap_pos_ += len + 1;
+		return;
+	}
 	read(dst, len + 1);
 }
 
 void DatabaseFile::skip_id_data() {
+	if (mmap_) {
+		const char* p = mmap_pos_ < mmap_->length() ? (const char*)memchr(mmap_->data() + mmap_pos_, '\0', mmap_->length() - mmap_pos_) : nullptr;
+		if (p == nullptr)
+			throw std::runtime_error("Unexpected end of file.");
+		mmap_pos_ = p - mmap_->data() + 1;
+		return;
+	}
 	if (!seek_forward('\0')) throw std::runtime_error("Unexpected end of file.");
 }
 
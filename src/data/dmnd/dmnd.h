@@ -25,10 +25,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdint.h>
 #include <limits.h>
 #include <list>
+#include <memory>
 #include "../util/io/serializer.h"
 #include "../util/io/input_file.h"
 #include "../sequence_file.h"
 #include "../taxon_list.h"
+#include "../../lib/mio/forward.h"
 
 struct ReferenceHeader
 {
@@ -44,6 +46,7 @@ struct ReferenceHeader
 	uint64_t sequences, letters, pos_array_offset;
 	static const uint32_t current_db_version_prot;
 	static const uint32_t current_db_version_nucl;
+	static const uint32_t packed_db_version_prot;
 	static constexpr uint64_t MAGIC_NUMBER = 0x24af8a415ee186dllu;
 	friend InputFile& operator>>(InputFile& file, ReferenceHeader& h);
 };
@@ -163,9 +166,17 @@ struct DatabaseFile : public SequenceFile, public InputFile
 private:
 
 	void init(Flags flags = Flags::NONE);
+	void init_mmap();
 	void read_seqid_list();
+	void read_packed_seq(std::vector<Letter>& seq);
 
 	std::unique_ptr<TaxonList> taxon_list_;
 	std::vector<std::string> taxon_scientific_names_;
+	// Mapping of the database file used to read sequences and ids (--mmap-db), and the read position within it.
+	std::unique_ptr<mio::mmap_source> mmap_;
+	size_t mmap_pos_;
+	// Letters are stored 5-bit packed (database version packed_db_version_prot).
+	bool packed_;
+	std::vector<char> packed_buf_;
 
 };
@@ -136,6 +136,10 @@ void FastaFile::set_seqinfo_ptr(OId i) {
 	}
 }
 
+bool FastaFile::input_ready(int timeout_ms) {
+	return file_ptr_->wait_readable(timeout_ms);
+}
+
 OId FastaFile::tell_seq() const {
 	return oid_;
 }
@@ -31,6 +31,7 @@ struct FastaFile : public SequenceFile
 	virtual void skip_id_data() override;
 	virtual int64_t sequence_count() const override;
 	virtual bool read_seq(std::vector<Letter>& seq, std::string& id, std::vector<char>* quals = nullptr) override;
+	virtual bool input_ready(int timeout_ms) override;
 	virtual size_t letters() const override;
 	virtual int db_version() const override;
 	virtual int program_build_version() const override;
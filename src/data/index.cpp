@@ -4,37 +4,67 @@
 #include "../search/search.h"
 #include "seed_set.h"
 #include "dmnd/dmnd.h"
+#include "seed_array.h"
+#include "block/block.h"
+#include "../masking/masking.h"
 
 void makeindex() {
 	static const size_t MAX_LETTERS = 100000000;
 	if (config.database.empty())
 		throw std::runtime_error("Missing parameter: database file (--db/-d).");
 	DatabaseFile db(config.database);
-	if (db.ref_header.letters > MAX_LETTERS)
+	if (db.ref_header.letters > MAX_LETTERS && !config.seed_arrays)
 		throw std::runtime_error("Indexing is only supported for databases of < 100000000 letters.");
 
 	::shapes = ShapeConfig(config.shape_mask.empty() ? Search::shape_codes[(int)align_mode.sequence_type].at(config.sensitivity) : config.shape_mask, config.shapes);
 	config.algo = Config::Algo::DOUBLE_INDEXED;
 
-	Block* block = db.load_seqs(MAX_LETTERS, nullptr, SequenceFile::LoadFlags::SEQS);
+	TaskTimer timer;
+	if (db.ref_header.letters <= MAX_LETTERS) {
+		timer.go("Loading sequences");
+		Block* block = db.load_seqs(MAX_LETTERS, nullptr, SequenceFile::LoadFlags::SEQS);
+		timer.go("Building index");
+		HashedSeedSet index(*block, nullptr, 0.0, Search::soft_masking_algo(Search::sensitivity_traits[(int)align_mode.sequence_type].at(config.sensitivity)));
 
-	TaskTimer timer("Building index");
-	HashedSeedSet index(*block, nullptr, 0.0, Search::soft_masking_algo(Search::sensitivity_traits[(int)align_mode.sequence_type].at(config.sensitivity)));
+		timer.go("Writing to disk");
+		OutputFile out(db.file_name() + ".seed_idx");
+		out.write(SEED_INDEX_MAGIC_NUMBER);
+		out.write(SEED_INDEX_VERSION);
+		out.write((uint32_t)shapes.count());
 
-	timer.go("Writing to disk");
-	OutputFile out(db.file_name() + ".seed_idx");
-	out.write(SEED_INDEX_MAGIC_NUMBER);
-	out.write(SEED_INDEX_VERSION);
-	out.write((uint32_t)shapes.count());
+		for (unsigned i = 0; i < shapes.count(); ++i)
+			out.write(index.table(i).size());
 
-	for (unsigned i = 0; i < shapes.count(); ++i)
-		out.write(index.table(i).size());
+		for (unsigned i = 0; i < shapes.count(); ++i) {
+			out.write(index.table(i).data(), index.table(i).size() + HashedSeedSet::Table::PADDING);
+		}
 
-	for (unsigned i = 0; i < shapes.count(); ++i) {
-		out.write(index.table(i).data(), index.table(i).size() + HashedSeedSet::Table::PADDING);
+		out.close();
+		delete block;
 	}
 
-	out.close();
+	if (config.seed_arrays) {
+		// One file per reference block. The block size is recorded in the files and used by the search.
+		::Config::set_option(config.chunk_size, config.sensitivity >= Sensitivity::VERY_SENSITIVE ? 0.4 : 2.0);
+		Search::Config cfg;
+		Search::setup_search(config.sensitivity, cfg);
+		db.set_seqinfo_ptr(0);
+		for (int b = 0;; ++b) {
+			timer.go("Loading reference block " + std::to_string(b + 1));
+			Block* block = db.load_seqs(config.block_size(), nullptr, SequenceFile::LoadFlags::SEQS);
+			if (block->empty()) {
+				delete block;
+				break;
+			}
+			timer.go("Masking reference block " + std::to_string(b + 1));
+			if (cfg.target_masking != MaskingAlgo::NONE)
+				mask_seqs(block->seqs(), Masking::get(), true, cfg.target_masking);
+			timer.go("Building seed arrays for block " + std::to_string(b + 1));
+			SeedArrayIndex::write(*block, cfg, config.sensitivity, SeedArrayIndex::file_name(db.file_name(), b));
+			delete block;
+		}
+	}
+
+	timer.finish();
 	db.close();
-	delete block;
 }
\ No newline at end of file
@@ -26,6 +26,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "enum_seeds.h"
 #include "../util/data_structures/deque.h"
 #include "../search/seed_complexity.h"
+#include "../lib/mio/mmap.hpp"
+#include "../util/io/output_file.h"
+#include "../util/algo/partition.h"
+#include "block/block.h"
 
 using std::array;
 using std::vector;
@@ -239,4 +243,177 @@ SeedArray<SeedLoc>::SeedArray(Block& seqs, const SeedPartitionRange& range, cons
 }
 
 template SeedArray<PackedLoc>::SeedArray(Block&, const SeedPartitionRange&, const HashedSeedSet*, EnumCfg&);
-template SeedArray<PackedLocId>::SeedArray(Block&, const SeedPartitionRange&, const HashedSeedSet*, EnumCfg&);
\ No newline at end of file
+template SeedArray<PackedLocId>::SeedArray(Block&, const SeedPartitionRange&, const HashedSeedSet*, EnumCfg&);
+
+template<typename SeedLoc>
+SeedArray<SeedLoc>::SeedArray(const SeedArrayIndex& index, unsigned shape, const SeedPartitionRange& range, char* buffer) :
+	key_bits(index.key_bits()),
+	data_((Entry*)buffer)
+{
+	if (index.entry_size() != sizeof(Entry))
+		throw std::runtime_error("Seed array index has an incompatible entry size.");
+	const size_t offset = index.begin(shape, range.begin());
+	begin_[range.begin()] = 0;
+	for (int i = range.begin(); i < range.end(); ++i)
+		begin_[i + 1] = index.begin(shape, i + 1) - offset;
+	memcpy(buffer, index.data(offset), begin_[range.end()] * sizeof(Entry));
+}
+
+template SeedArray<PackedLoc>::SeedArray(const SeedArrayIndex&, unsigned, const SeedPartitionRange&, char*);
+template SeedArray<PackedLocId>::SeedArray(const SeedArrayIndex&, unsigned, const SeedPartitionRange&, char*);
+
+template<typename T>
+static T read_header(const char* buf, size_t offset) {
+	T x;
+	memcpy(&x, buf + offset, sizeof(T));
+	return x;
+}
+
+static const char* open_index(const mio::mmap_source& f) {
+	const char* buf = f.data();
+	if (f.length() < SEED_ARRAY_INDEX_HEADER_SIZE || read_header<uint64_t>(buf, 0) != SEED_ARRAY_INDEX_MAGIC_NUMBER)
+		throw std::runtime_error("Invalid seed array index file.");
+	if (read_header<uint32_t>(buf, 8) != SEED_ARRAY_INDEX_VERSION)
+		throw std::runtime_error("Seed array index file was written by a different program version. Rebuild it using makeidx --seed-arrays.");
+	return buf;
+}
+
+SeedArrayIndex::SeedArrayIndex(const std::string& index_file) :
+	mmap_(new mio::mmap_source(index_file)),
+	file_name_(index_file)
+{
+	const char* buf = open_index(*mmap_);
+	shape_count_ = read_header<uint32_t>(buf, 12);
+	entry_size_ = read_header<uint32_t>(buf, 16);
+	key_bits_ = read_header<int32_t>(buf, 20);
+	sequences_ = read_header<uint64_t>(buf, 24);
+	letters_ = read_header<uint64_t>(buf, 32);
+	masking_ = (MaskingAlgo)read_header<uint32_t>(buf, 40);
+	sensitivity_ = (Sensitivity)read_header<int32_t>(buf, 44);
+	oid_begin_ = read_header<uint64_t>(buf, 48);
+	block_size_ = read_header<double>(buf, 56);
+	seed_cut_ = read_header<double>(buf, 64);
+	soft_masking_ = (MaskingAlgo)read_header<uint32_t>(buf, 72);
+	minimizer_window_ = read_header<int32_t>(buf, 76);
+	seed_encoding_ = (SeedEncoding)read_header<uint32_t>(buf, 80);
+	if (mmap_->length() < SEED_ARRAY_INDEX_HEADER_SIZE + shape_count_ * 2 * sizeof(uint32_t))
+		throw std::runtime_error("Seed array index file is truncated.");
+	for (uint32_t i = 0; i < shape_count_; ++i)
+		shapes_.emplace_back(read_header<uint32_t>(buf, SEED_ARRAY_INDEX_HEADER_SIZE + i * 8), read_header<uint32_t>(buf, SEED_ARRAY_INDEX_HEADER_SIZE + i * 8 + 4));
+	offsets_ = buf + SEED_ARRAY_INDEX_HEADER_SIZE + shape_count_ * 2 * sizeof(uint32_t);
+	if (mmap_->length() < size_t(offsets_ - buf) + shape_count_ * (Const::seedp + 1) * sizeof(uint64_t))
+		throw std::runtime_error("Seed array index file is truncated.");
+	data_ = offsets_ + shape_count_ * (Const::seedp + 1) * sizeof(uint64_t);
+	letters_data_ = shape_count_ > 0 ? data(begin(shape_count_ - 1, Const::seedp)) : data_;
+	if (mmap_->length() < size_t(letters_data_ - buf))
+		throw std::runtime_error("Seed array index file is truncated.");
+	letters_size_ = mmap_->length() - size_t(letters_data_ - buf);
+}
+
+SeedArrayIndex::~SeedArrayIndex() {
+}
+
+std::string SeedArrayIndex::file_name(const std::string& db_file, int ref_block) {
+	return db_file + ".seed_arr" + (ref_block == 0 ? std::string() : "." + std::to_string(ref_block));
+}
+
+double SeedArrayIndex::block_size(const std::string& index_file) {
+	mio::mmap_source f(index_file);
+	return read_header<double>(open_index(f), 56);
+}
+
+void SeedArrayIndex::check(const Block& seqs, const Search::Config& cfg, Sensitivity sensitivity) const {
+	const auto fail = [this](const char* what) {
+		throw std::runtime_error(std::string("The seed array index file ") + file_name_ + " was built with a different " + what
+			+ ". Rebuild it using makeidx --seed-arrays with the options of the search, or run without --seed-arrays.");
+	};
+	if ((uint64_t)seqs.seqs().size() != sequences_ || (uint64_t)seqs.seqs().letters() != letters_)
+		fail("database or block");
+	for (BlockId i = 0; i < seqs.seqs().size(); ++i)
+		if ((uint64_t)seqs.block_id2oid(i) != oid_begin_ + i)
+			fail("database or block");
+	if (block_size_ != config.chunk_size)
+		fail("block size");
+	if (sensitivity_ != sensitivity)
+		fail("sensitivity");
+	if (shape_count_ != shapes.count())
+		fail("number of seed shapes");
+	for (unsigned i = 0; i < shape_count_; ++i)
+		if ((int32_t)shapes_[i].first != shapes[i].length_ || shapes_[i].second != shapes[i].mask_)
+			fail("seed shape");
+	if (seed_encoding_ != cfg.seed_encoding || key_bits_ != (int)seed_bits(cfg.seed_encoding))
+		fail("seed encoding");
+	if (seed_cut_ != cfg.seed_complexity_cut)
+		fail("seed complexity cutoff");
+	if (soft_masking_ != cfg.soft_masking)
+		fail("soft masking");
+	if (minimizer_window_ != cfg.minimizer_window)
+		fail("minimizer window");
+	if (masking_ != cfg.target_masking)
+		fail("masking");
+}
+
+bool SeedArrayIndex::load_masking(SequenceSet& seqs, MaskingAlgo masking) const {
+	if (masking != masking_ || letters_size_ != (size_t)seqs.raw_len())
+		return false;
+	memcpy(seqs.data(), letters_data_, letters_size_);
+	seqs.alphabet() = Alphabet::STD;
+	return true;
+}
+
+size_t SeedArrayIndex::max_chunk_size(int index_chunks) const {
+	size_t max = 0;
+	::Partition<int> p(Const::seedp, index_chunks);
+	for (unsigned shape = 0; shape < shape_count_; ++shape)
+		for (int chunk = 0; chunk < p.parts; ++chunk)
+			max = std::max(max, begin(shape, p.end(chunk)) - begin(shape, p.begin(chunk)));
+	return max;
+}
+
+void SeedArrayIndex::write(Block& seqs, const Search::Config& search_cfg, Sensitivity sensitivity, const std::string& file_name) {
+	using Entry = SeedArray<PackedLoc>::Entry;
+	EnumCfg cfg{ nullptr, 0, 0, search_cfg.seed_encoding, nullptr, false, false, search_cfg.seed_complexity_cut, search_cfg.soft_masking, search_cfg.minimizer_window, false, false };
+	seqs.hst() = SeedHistogram(seqs, false, &no_filter, cfg);
+	const SeedHistogram& hst = seqs.hst();
+
+	OutputFile out(file_name);
+	out.write(SEED_ARRAY_INDEX_MAGIC_NUMBER);
+	out.write(SEED_ARRAY_INDEX_VERSION);
+	out.write((uint32_t)shapes.count());
+	out.write((uint32_t)sizeof(Entry));
+	out.write((int32_t)seed_bits(search_cfg.seed_encoding));
+	out.write((uint64_t)seqs.seqs().size());
+	out.write((uint64_t)seqs.seqs().letters());
+	out.write((uint32_t)search_cfg.target_masking);
+	out.write((int32_t)sensitivity);
+	out.write((uint64_t)(seqs.seqs().size() > 0 ? seqs.block_id2oid(0) : 0));
+	out.write(config.chunk_size);
+	out.write(search_cfg.seed_complexity_cut);
+	out.write((uint32_t)search_cfg.soft_masking);
+	out.write((int32_t)search_cfg.minimizer_window);
+	out.write((uint32_t)search_cfg.seed_encoding);
+	out.write((uint32_t)0);
+	for (unsigned shape = 0; shape < shapes.count(); ++shape) {
+		out.write((uint32_t)shapes[shape].length_);
+		out.write((uint32_t)shapes[shape].mask_);
+	}
+
+	uint64_t offset = 0;
+	for (unsigned shape = 0; shape < shapes.count(); ++shape)
+		for (int p = 0; p <= Const::seedp; ++p) {
+			out.write(offset);
+			if (p < Const::seedp)
+				offset += partition_size(hst.get(shape), p);
+		}
+
+	std::unique_ptr<char[]> buffer(SeedArray<PackedLoc>::alloc_buffer(hst, 1));
+	for (unsigned shape = 0; shape < shapes.count(); ++shape) {
+		cfg.partition = &hst.partition();
+		cfg.shape_begin = shape;
+		cfg.shape_end = shape + 1;
+		SeedArray<PackedLoc> seed_array(seqs, hst.get(shape), SeedPartitionRange::all(), buffer.get(), &no_filter, cfg);
+		out.write(buffer.get(), seed_array.size() * sizeof(Entry));
+	}
+	out.write(seqs.seqs().data(), (size_t)seqs.seqs().raw_len());
+	out.close();
+}
@@ -17,15 +17,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ****/
 
 #pragma once
+#include <string.h>
 #include <array>
 #include <vector>
+#include <memory>
+#include <string>
 #include "seed_histogram.h"
 #include "../search/seed_complexity.h"
 #include "flags.h"
+#include "../lib/mio/forward.h"
 
 #pragma pack(1)
 
 struct Block;
+struct SequenceSet;
+struct SeedArrayIndex;
 
 template<typename SeedLoc>
 struct SeedArray
@@ -80,6 +86,8 @@ struct SeedArray
 	template<typename Filter>
 	SeedArray(Block& seqs, const SeedPartitionRange& range, const Filter* filter, EnumCfg& cfg);
 
+	SeedArray(const SeedArrayIndex& index, unsigned shape, const SeedPartitionRange& range, char* buffer);
+
 	Entry* begin(unsigned i)
 	{
 		if (data_)
@@ -133,4 +141,58 @@ private:
 
 };
 
-#pragma pack()
\ No newline at end of file
+#pragma pack()
+
+const uint64_t SEED_ARRAY_INDEX_MAGIC_NUMBER = 0x4c8e1f0b95d7a2e3;
+const uint32_t SEED_ARRAY_INDEX_VERSION = 3;
+const size_t SEED_ARRAY_INDEX_HEADER_SIZE = 88;
+
+// Reference seed arrays for all shapes as written by makeidx --seed-arrays, followed by the
+// masked reference letters. The file is memory mapped and the partitions of a chunk are copied
+// into the reference buffer on demand, so concurrent searches share it through the page cache.
+// Databases larger than the block size get one file per reference block, which is used by a
+// search that loads the same block. The header records the block size and the seed settings, a
+// search with different settings rejects the file.
+struct SeedArrayIndex
+{
+	SeedArrayIndex(const std::string& index_file);
+	~SeedArrayIndex();
+	static std::string file_name(const std::string& db_file, int ref_block);
+	static void write(Block& seqs, const Search::Config& cfg, Sensitivity sensitivity, const std::string& file_name);
+	static double block_size(const std::string& index_file);
+	void check(const Block& seqs, const Search::Config& cfg, Sensitivity sensitivity) const;
+	bool load_masking(SequenceSet& seqs, MaskingAlgo masking) const;
+	size_t max_chunk_size(int index_chunks) const;
+	size_t begin(unsigned shape, int p) const
+	{
+		uint64_t x;
+		memcpy(&x, offsets_ + (shape * (Const::seedp + 1) + p) * sizeof(uint64_t), sizeof(x));
+		return x;
+	}
+	const char* data(size_t i) const
+	{
+		return data_ + i * entry_size_;
+	}
+	uint32_t entry_size() const
+	{
+		return entry_size_;
+	}
+	int key_bits() const
+	{
+		return key_bits_;
+	}
+private:
+	std::unique_ptr<mio::mmap_source> mmap_;
+	std::string file_name_;
+	uint32_t shape_count_, entry_size_;
+	MaskingAlgo masking_, soft_masking_;
+	Sensitivity sensitivity_;
+	SeedEncoding seed_encoding_;
+	int key_bits_;
+	Loc minimizer_window_;
+	uint64_t sequences_, letters_, oid_begin_;
+	double block_size_, seed_cut_;
+	std::vector<std::pair<uint32_t, uint32_t>> shapes_;
+	const char* offsets_, *data_, *letters_data_;
+	size_t letters_size_;
+};
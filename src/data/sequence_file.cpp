@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <fstream>
 #include <iostream>
 #include <thread>
+#include <chrono>
 #include "sequence_file.h"
 #include "../masking/masking.h"
 #include "reference.h"
@@ -214,7 +215,16 @@ std::pair<Block*, int64_t> SequenceFile::load_onepass(const int64_t max_letters,
 	OId oid = tell_seq();
 	const int frame_mask = ::frame_mask();
 	const int64_t modulo = file_count();
+	// With a latency bound, the block is closed once the bound has passed since its first sequence was read, or if the
+	// input stalls for the remaining time. A sequence is never split, so a record arriving slowly can exceed the bound.
+	const bool latency = flag_any(flags, LoadFlags::BATCH_LATENCY);
+	std::chrono::steady_clock::time_point t0;
 	do {
+		if (latency && seq_count > 0 && seq_count % modulo == 0) {
+			const int64_t left = config.query_batch_latency - std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+			if (left <= 0 || !input_ready((int)left))
+				break;
+		}
 		if (!read_seq(seq, id, q))
 			break;
 		if (seq.size() == 0)
@@ -226,7 +236,8 @@ std::pair<Block*, int64_t> SequenceFile::load_onepass(const int64_t max_letters,
 
 		letters += block->push_back(Sequence(seq), load_titles ? id.c_str() : nullptr, q, oid++, this->value_traits_.seq_type, frame_mask, !preserve_dna);
 
-        ++seq_count;
+        if (++seq_count == 1)
+			t0 = std::chrono::steady_clock::now();
 		if (seq_count <= CHECK_FOR_DNA_COUNT && value_traits_.seq_type == SequenceType::amino_acid && Util::Seq::looks_like_dna(Sequence(seq)) && !config.ignore_warnings)
 			throw std::runtime_error("The sequences are expected to be proteins but only contain DNA letters. Use the option --ignore-warnings to proceed.");
 	} while (letters < max_letters || seq_count % modulo != 0);
@@ -92,19 +92,24 @@ struct SequenceFile {
 		CONVERT_ALPHABET = 1 << 4,
 		NO_CLOSE_WEAKLY = 1 << 5,
         DNA_PRESERVATION = 1 << 6,
+		BATCH_LATENCY = 1 << 7,
         ALL = SEQS | TITLES
 	};
 
 	struct SeqInfo
 	{
-		SeqInfo()
+		SeqInfo():
+			mask_bytes(0)
 		{}
-		SeqInfo(uint64_t pos, size_t len) :
+		SeqInfo(uint64_t pos, size_t len, uint32_t mask_bytes = 0) :
 			pos(pos),
-			seq_len(uint32_t(len))
+			seq_len(uint32_t(len)),
+			mask_bytes(mask_bytes)
 		{}
 		uint64_t pos;
 		uint32_t seq_len;
+		// Size of the masking information stored with the letters (packed .dmnd files).
+		uint32_t mask_bytes;
 		enum { SIZE = 16 };
 	};
 
@@ -135,6 +140,10 @@ struct SequenceFile {
 	virtual int db_version() const = 0;
 	virtual int program_build_version() const = 0;
 	virtual bool read_seq(std::vector<Letter>& seq, std::string& id, std::vector<char>* quals = nullptr) = 0;
+	// Returns true if the next sequence can be read without waiting for input, waiting up to timeout_ms milliseconds.
+	virtual bool input_ready(int timeout_ms) {
+		return true;
+	}
 	virtual Metadata metadata() const = 0;
 	virtual std::string taxon_scientific_name(TaxId taxid) const;
 	virtual int build_version() = 0;
@@ -6,8 +6,23 @@
 
 using std::min;
 
+#if ARCH_ID == 3
+namespace DP { namespace PrefixScan { namespace ARCH_AVX2 {
+Hsp align_anchored(const Anchor& anchor, const Config& cfg);
+}}}
+#endif
+
 namespace DP { namespace PrefixScan { namespace DISPATCH_ARCH {
 
+#if ARCH_ID == 3
+
+// The prefix scan kernels are written for 256 bit registers.
+Hsp align_anchored(const Anchor& anchor, const Config& cfg) {
+	return ::DP::PrefixScan::ARCH_AVX2::align_anchored(anchor, cfg);
+}
+
+#else
+
 #ifdef __SSE2__
 
 Hsp align16(const Config& cfg) {
@@ -186,6 +201,8 @@ Hsp align_anchored(const Anchor& anchor, const Config& cfg) {
 	return h;
 }
 
+#endif
+
 }
 
 DISPATCH_2(Hsp, align_anchored, const Anchor&, anchor, const Config&, cfg)
@@ -29,7 +29,7 @@ SOFTWARE.
 
 namespace DP { namespace PrefixScan { namespace DISPATCH_ARCH {
 
-#if ARCH_ID == 2 || ARCH_ID == 3
+#if ARCH_ID == 2
 
 template<int DELTA>
 static inline std::pair<::DISPATCH_ARCH::ScoreVector<int16_t, DELTA>, ::DISPATCH_ARCH::ScoreVector<int16_t, DELTA >> prefix_scan_consts(const ::DISPATCH_ARCH::ScoreVector<int16_t, DELTA> gap) {
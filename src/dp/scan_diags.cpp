@@ -31,7 +31,28 @@ namespace DP { namespace DISPATCH_ARCH {
 
 void scan_diags128(const LongScoreProfile<int8_t>& qp, Sequence s, int d_begin, int j_begin, int j_end, int *out)
 {
-#ifdef __AVX2__
+#if ARCH_ID == 3
+	using Sv = ScoreVector<int8_t, SCHAR_MIN>;
+	const int qlen = (int)qp.length();
+
+	const int j0 = std::max(j_begin, -(d_begin + 128 - 1)),
+		i0 = d_begin + j0,
+		j1 = std::min(qlen - d_begin, j_end);
+	Sv v1, max1, v2, max2;
+	for (int i = i0, j = j0; j < j1; ++j, ++i) {
+		const int8_t* q = qp.get(s[j], i);
+		v1 += Sv(q);
+		max1.max(v1);
+		q += 64;
+		v2 += Sv(q);
+		max2.max(v2);
+	}
+	int8_t scores[128];
+	max1.store(scores);
+	max2.store(scores + 64);
+	for (int i = 0; i < 128; ++i)
+		out[i] = ScoreTraits<Sv>::int_score(scores[i]);
+#elif defined(__AVX2__)
 	using Sv = ScoreVector<int8_t, SCHAR_MIN>;
 	const int qlen = (int)qp.length();
 
@@ -129,7 +150,23 @@ void scan_diags128(const LongScoreProfile<int8_t>& qp, Sequence s, int d_begin,
 
 void scan_diags64(const LongScoreProfile<int8_t>& qp, Sequence s, int d_begin, int j_begin, int j_end, int* out)
 {
-#ifdef __AVX2__
+#if ARCH_ID == 3
+	using Sv = ScoreVector<int8_t, SCHAR_MIN>;
+	const int qlen = (int)qp.length();
+
+	const int j0 = std::max(j_begin, -(d_begin + 64 - 1)),
+		i0 = d_begin + j0,
+		j1 = std::min(qlen - d_begin, j_end);
+	Sv v1, max1;
+	for (int i = i0, j = j0; j < j1; ++j, ++i) {
+		v1 += Sv(qp.get(s[j], i));
+		max1.max(v1);
+	}
+	int8_t scores[64];
+	max1.store(scores);
+	for (int i = 0; i < 64; ++i)
+		out[i] = ScoreTraits<Sv>::int_score(scores[i]);
+#elif defined(__AVX2__)
 	using Sv = ScoreVector<int8_t, SCHAR_MIN>;
 	const int qlen = (int)qp.length();
 
@@ -203,7 +240,24 @@ void scan_diags64(const LongScoreProfile<int8_t>& qp, Sequence s, int d_begin, i
 
 void scan_diags(const LongScoreProfile<int8_t>& qp, Sequence s, int d_begin, int d_end, int j_begin, int j_end, int* out)
 {
-#ifdef __AVX2__
+#if ARCH_ID == 3
+	using Sv = ScoreVector<int8_t, SCHAR_MIN>;
+	const int qlen = (int)qp.length(), band = d_end - d_begin;
+	assert(band % 32 == 0);
+
+	const int j0 = std::max(j_begin, -(d_end - 1)),
+		i0 = d_begin + j0,
+		j1 = std::min(qlen - d_begin, j_end);
+	Sv v1, max1;
+	for (int i = i0, j = j0; j < j1; ++j, ++i) {
+		v1 += Sv(qp.get(s[j], i));
+		max1.max(v1);
+	}
+	int8_t scores[64];
+	max1.store(scores);
+	for (int i = 0; i < 64; ++i)
+		out[i] = ScoreTraits<Sv>::int_score(scores[i]);
+#elif defined(__AVX2__)
 	using Sv = ScoreVector<int8_t, SCHAR_MIN>;
 	const int qlen = (int)qp.length(), band = d_end - d_begin;
 	assert(band % 32 == 0);
@@ -131,11 +131,11 @@ static inline typename DISPATCH_ARCH::ScoreTraits<Sv>::Score extract(Sv sv, int
 }
 
 template<typename Sv>
-static Sv blend_sv(const typename DISPATCH_ARCH::ScoreTraits<Sv>::Score a, const typename DISPATCH_ARCH::ScoreTraits<Sv>::Score b, const uint32_t mask) {
+static Sv blend_sv(const typename DISPATCH_ARCH::ScoreTraits<Sv>::Score a, const typename DISPATCH_ARCH::ScoreTraits<Sv>::Score b, const uint64_t mask) {
 	const uint32_t CHANNELS = DISPATCH_ARCH::ScoreTraits<Sv>::CHANNELS;
-	alignas(32) typename DISPATCH_ARCH::ScoreTraits<Sv>::Score s[CHANNELS];
+	alignas(64) typename DISPATCH_ARCH::ScoreTraits<Sv>::Score s[CHANNELS];
 	for (uint32_t i = 0; i < CHANNELS; ++i)
-		if (mask & (1 << i))
+		if (mask & ((uint64_t)1 << i))
 			s[i] = b;
 		else
 			s[i] = a;
@@ -143,7 +143,7 @@ static Sv blend_sv(const typename DISPATCH_ARCH::ScoreTraits<Sv>::Score a, const
 }
 
 template<>
-int32_t blend_sv<int32_t>(const int32_t a, const int32_t b, const uint32_t mask) {
+int32_t blend_sv<int32_t>(const int32_t a, const int32_t b, const uint64_t mask) {
 	return mask ? b : a;
 }
 
@@ -28,6 +28,22 @@ namespace DISPATCH_ARCH {
 
 #if ARCH_ID == 3
 
+struct TraceBits {
+	TraceBits operator&(const TraceBits& m) const {
+		return { v & m.v, h & m.h };
+	}
+	TraceBits operator|(const TraceBits& m) const {
+		return { v | m.v, h | m.h };
+	}
+	bool operator==(int x) const {
+		return (v | h) == (uint64_t)x;
+	}
+	explicit operator bool() const {
+		return (v | h) != 0;
+	}
+	uint64_t v, h;
+};
+
 template<int DELTA>
 struct ScoreVector<int8_t, DELTA>
 {
@@ -58,19 +74,16 @@ struct ScoreVector<int8_t, DELTA>
 
 	ScoreVector(unsigned a, __m512i seq)
 	{
-		/*const __m256i* row_lo = reinterpret_cast<const __m256i*>(&score_matrix.matrix8_low()[a << 5]);
-		const __m256i* row_hi = reinterpret_cast<const __m256i*>(&score_matrix.matrix8_high()[a << 5]);
+		const __m128i* row_lo = reinterpret_cast<const __m128i*>(&score_matrix.matrix8_low()[a << 5]);
+		const __m128i* row_hi = reinterpret_cast<const __m128i*>(&score_matrix.matrix8_high()[a << 5]);
 
-		__m256i high_mask = _mm256_slli_epi16(_mm256_and_si256(seq, _mm256_set1_epi8('\x10')), 3);
-		__m256i seq_low = _mm256_or_si256(seq, high_mask);
-		__m256i seq_high = _mm256_or_si256(seq, _mm256_xor_si256(high_mask, _mm256_set1_epi8('\x80')));
+		seq = letter_mask(seq);
 
-		__m256i r1 = _mm512_load_si512(row_lo);
-		__m256i r2 = _mm512_load_si512(row_hi);
+		const __m512i r1 = _mm512_broadcast_i32x4(_mm_load_si128(row_lo));
+		const __m512i r2 = _mm512_broadcast_i32x4(_mm_load_si128(row_hi));
+		const __mmask64 high = _mm512_test_epi8_mask(seq, _mm512_set1_epi8('\x10'));
 
-		__m256i s1 = _mm256_shuffle_epi8(r1, seq_low);
-		__m256i s2 = _mm256_shuffle_epi8(r2, seq_high);
-		data_ = _mm256_or_si256(s1, s2);*/
+		data_ = _mm512_mask_blend_epi8(high, _mm512_shuffle_epi8(r1, seq), _mm512_shuffle_epi8(r2, seq));
 	}
 
 	ScoreVector operator+(const ScoreVector& rhs) const
@@ -105,25 +118,34 @@ struct ScoreVector<int8_t, DELTA>
 	}
 
 	friend ScoreVector blend(const ScoreVector&v, const ScoreVector&w, const ScoreVector&mask) {
-		return ScoreVector(); // (_mm256_blendv_epi8(v.data_, w.data_, mask.data_));
+		return ScoreVector(_mm512_mask_blend_epi8(_mm512_movepi8_mask(mask.data_), v.data_, w.data_));
 	}
 
 	ScoreVector operator==(const ScoreVector&v) const {
-		return ScoreVector(); // ScoreVector(_mm256_cmpeq_epi8(data_, v.data_));
+		return ScoreVector(_mm512_movm_epi8(_mm512_cmpeq_epi8_mask(data_, v.data_)));
 	}
 
-	friend uint32_t cmp_mask(const ScoreVector&v, const ScoreVector&w) {
-		return 0; // (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v.data_, w.data_));
+	ScoreVector operator>(const ScoreVector& v) const {
+		return ScoreVector(_mm512_movm_epi8(_mm512_cmpgt_epi8_mask(data_, v.data_)));
+	}
+
+	friend uint64_t cmp_mask(const ScoreVector&v, const ScoreVector&w) {
+		return (uint64_t)_mm512_cmpeq_epi8_mask(v.data_, w.data_);
 	}
 
 	int operator [](unsigned i) const
 	{
-		return *(((uint8_t*)&data_) + i);
+		alignas(64) int8_t s[64];
+		_mm512_store_si512((__m512i*)s, data_);
+		return s[i];
 	}
 
-	ScoreVector& set(unsigned i, uint8_t v)
+	ScoreVector& set(unsigned i, int8_t v)
 	{
-		*(((uint8_t*)&data_) + i) = v;
+		alignas(64) int8_t s[64];
+		_mm512_store_si512((__m512i*)s, data_);
+		s[i] = v;
+		data_ = _mm512_load_si512((const __m512i*)s);
 		return *this;
 	}
 
@@ -154,21 +176,46 @@ struct ScoreVector<int8_t, DELTA>
 		_mm512_storeu_si512((__m512i*)ptr, data_);
 	}
 
+	void store_aligned(int8_t* ptr) const
+	{
+		_mm512_store_si512((__m512i*)ptr, data_);
+	}
+
 	friend std::ostream& operator<<(std::ostream& s, ScoreVector v)
 	{
-		int8_t x[32];
+		int8_t x[64];
 		v.store(x);
-		for (unsigned i = 0; i < 32; ++i)
+		for (unsigned i = 0; i < 64; ++i)
 			printf("%3i ", (int)x[i]);
 		return s;
 	}
 
+	static ScoreVector load_aligned(const int8_t* x) {
+		return ScoreVector(_mm512_load_si512((const __m512i*)x));
+	}
+
 	void expand_from_8bit() {}
 
 	__m512i data_;
 
 };
 
+template<int i, int DELTA>
+static inline int8_t extract(ScoreVector<int8_t, DELTA> sv) {
+	return (int8_t)_mm_extract_epi8(_mm512_extracti32x4_epi32(sv.data_, i / 16), i % 16);
+}
+
+template<int DELTA>
+static inline void store_expanded(ScoreVector<int8_t, DELTA> sv, int16_t* dst) {
+	_mm512_storeu_si512((__m512i*)dst, _mm512_cvtepi8_epi16(_mm512_castsi512_si256(sv.data_)));
+	_mm512_storeu_si512((__m512i*)(dst + 32), _mm512_cvtepi8_epi16(_mm512_extracti64x4_epi64(sv.data_, 1)));
+}
+
+template<int DELTA>
+static inline void store_expanded(ScoreVector<int8_t, DELTA> sv, int8_t* dst) {
+	_mm512_storeu_si512((__m512i*)dst, sv.data_);
+}
+
 template<int DELTA>
 struct ScoreTraits<ScoreVector<int8_t, DELTA>>
 {
@@ -176,19 +223,19 @@ struct ScoreTraits<ScoreVector<int8_t, DELTA>>
 	typedef ::DISPATCH_ARCH::SIMD::Vector<int8_t> Vector;
 	typedef int8_t Score;
 	typedef uint8_t Unsigned;
-	typedef uint32_t Mask;
+	typedef uint64_t Mask;
 	struct TraceMask {
-		static uint64_t make(uint32_t vmask, uint32_t hmask) {
-			return (uint64_t)vmask << 32 | (uint64_t)hmask;
+		static TraceBits make(uint64_t vmask, uint64_t hmask) {
+			return { vmask, hmask };
 		}
-		static uint64_t vmask(int channel) {
-			return (uint64_t)1 << (channel + 32);
+		static TraceBits vmask(int channel) {
+			return { (uint64_t)1 << channel, 0 };
 		}
-		static uint64_t hmask(int channel) {
-			return (uint64_t)1 << channel;
+		static TraceBits hmask(int channel) {
+			return { 0, (uint64_t)1 << channel };
 		}
-		uint64_t gap;
-		uint64_t open;
+		TraceBits gap;
+		TraceBits open;
 	};
 	static ScoreVector<int8_t, DELTA> zero() {
 		return ScoreVector<int8_t, DELTA>();
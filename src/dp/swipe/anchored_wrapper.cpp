@@ -1,4 +1,6 @@
 #include <memory>
+#include <algorithm>
+#include <numeric>
 #include "../dp.h"
 #include "anchored.h"
 #include "../score_profile.h"
@@ -15,8 +17,23 @@ using std::sort;
 using std::runtime_error;
 using std::accumulate;
 
+#if ARCH_ID == 3
+namespace DP { namespace BandedSwipe { namespace ARCH_AVX2 {
+list<Hsp> anchored_swipe(Targets& targets, const DP::AnchoredSwipe::Config& cfg);
+}}}
+#endif
+
 namespace DP { namespace BandedSwipe { namespace DISPATCH_ARCH {
 
+#if ARCH_ID == 3
+
+// The anchored SWIPE kernel uses 256 bit transposes and runs 16 channels wide.
+list<Hsp> anchored_swipe(Targets& targets, const DP::AnchoredSwipe::Config& cfg) {
+	return ::DP::BandedSwipe::ARCH_AVX2::anchored_swipe(targets, cfg);
+}
+
+#else
+
 struct TargetVector {
 	vector<DP::AnchoredSwipe::Target<int8_t>> int8;
 	vector<DP::AnchoredSwipe::Target<int16_t>> int16;
@@ -35,6 +52,76 @@ struct Profiles {
 	LongScoreProfile<int16_t> int16;
 };
 
+// Per thread state that is reused across calls: the forward and reversed profiles of the last query and the target
+// buffers.
+struct Context {
+	Context():
+		padding(0)
+	{}
+	void set_query(Sequence seq, const int8_t* cbs, int64_t padding) {
+		const Loc len = seq.length();
+		if (padding <= this->padding && query.size() == (size_t)len && std::equal(query.begin(), query.end(), seq.data())
+			&& (cbs ? query_cbs.size() == (size_t)len && std::equal(query_cbs.begin(), query_cbs.end(), cbs) : query_cbs.empty()))
+			return;
+		query.assign(seq.data(), seq.data() + len);
+		if (cbs)
+			query_cbs.assign(cbs, cbs + len);
+		else
+			query_cbs.clear();
+		this->padding = padding;
+		profiles.reset(new Profiles(seq, cbs, padding));
+		profiles_rev.reset(new Profiles(*profiles, Profiles::Reverse()));
+		prof_pointers = profiles->int16.pointers(0);
+		prof_pointers_rev = profiles_rev->int16.pointers(0);
+	}
+	vector<Letter> query;
+	vector<int8_t> query_cbs;
+	int64_t padding;
+	unique_ptr<Profiles> profiles, profiles_rev;
+	vector<const int16_t*> prof_pointers, prof_pointers_rev;
+	TargetVector targets;
+	vector<DP::AnchoredSwipe::Target<int16_t>> buffer;
+};
+
+static Context& context() {
+	thread_local Context context;
+	return context;
+}
+
+// Sorts the targets by band using a stable radix sort.
+static void sort_by_band(vector<DP::AnchoredSwipe::Target<int16_t>>& targets, vector<DP::AnchoredSwipe::Target<int16_t>>& buffer) {
+	using Target = DP::AnchoredSwipe::Target<int16_t>;
+	const size_t n = targets.size();
+	if (n <= 1)
+		return;
+	Loc max_band = 0;
+	for (const Target& t : targets)
+		max_band = std::max(max_band, t.band());
+	buffer.resize(n);
+	vector<size_t> hst;
+	Target* in = targets.data(), *out = buffer.data();
+	for (int shift = 0; (max_band >> shift) > 0; shift += config.radix_bits) {
+		const Loc mask = (Loc(1) << config.radix_bits) - 1;
+		hst.assign(size_t(mask) + 2, 0);
+		for (size_t i = 0; i < n; ++i)
+			++hst[((in[i].band() >> shift) & mask) + 1];
+		std::partial_sum(hst.begin(), hst.end(), hst.begin());
+		for (size_t i = 0; i < n; ++i)
+			out[hst[(in[i].band() >> shift) & mask]++] = in[i];
+		std::swap(in, out);
+	}
+	if (in != targets.data())
+		targets.swap(buffer);
+}
+
+// Restores the order of insertion. The target indices are a permutation of [0, n).
+static void sort_by_target_idx(vector<DP::AnchoredSwipe::Target<int16_t>>& targets, vector<DP::AnchoredSwipe::Target<int16_t>>& buffer) {
+	buffer.resize(targets.size());
+	for (const auto& t : targets)
+		buffer[t.target_idx] = t;
+	targets.swap(buffer);
+}
+
 static Loc get_band() {
 	return config.sensitivity >= Sensitivity::ULTRA_SENSITIVE ? 160 : (config.sensitivity >= Sensitivity::MORE_SENSITIVE ? 96 : 32);
 }
@@ -128,7 +215,6 @@ static void swipe_threads(DP::AnchoredSwipe::Target<int16_t>* targets, int64_t c
 list<Hsp> anchored_swipe(Targets& targets, const DP::AnchoredSwipe::Config& cfg) {
 	TaskTimer total;
 
-	TargetVector target_vec;
 	int64_t target_count = 0, target_len = 0;
 	Loc max_target_len = 0;
 	for (int bin = 0; bin < DP::BINS; ++bin)
@@ -139,14 +225,15 @@ list<Hsp> anchored_swipe(Targets& targets, const DP::AnchoredSwipe::Config& cfg)
 		}
 
 	TaskTimer timer;
+	Context& ctx = context();
+	TargetVector& target_vec = ctx.targets;
 	//target_vec.int8.reserve(target_count * 2);
+	target_vec.int16.clear();
 	target_vec.int16.reserve(target_count * 2);
 	cfg.stats.inc(Statistics::TIME_ANCHORED_SWIPE_ALLOC, timer.microseconds());
 
 	timer.go();
-	Profiles profiles(cfg.query, cfg.query_cbs, cfg.query.length() + max_target_len + 32),
-		profiles_rev(profiles, Profiles::Reverse());
-	const auto prof_pointers = profiles.int16.pointers(0), prof_pointers_rev = profiles_rev.int16.pointers(0);
+	ctx.set_query(cfg.query, cfg.query_cbs, cfg.query.length() + max_target_len + 32);
 	cfg.stats.inc(Statistics::TIME_PROFILE, timer.microseconds());	
 
 	timer.go();
@@ -160,12 +247,11 @@ list<Hsp> anchored_swipe(Targets& targets, const DP::AnchoredSwipe::Config& cfg)
 	auto& t = target_vec.int16;
 	
 	timer.go();
-	sort(target_vec.int8.begin(), target_vec.int8.end());
-	sort(target_vec.int16.begin(), target_vec.int16.end());
+	sort_by_band(target_vec.int16, ctx.buffer);
 	cfg.stats.inc(Statistics::TIME_ANCHORED_SWIPE_SORT, timer.microseconds());
 
 	DP::AnchoredSwipe::Stats stats;
-	DP::AnchoredSwipe::Options options{ prof_pointers.data(), prof_pointers_rev.data() };
+	DP::AnchoredSwipe::Options options{ ctx.prof_pointers.data(), ctx.prof_pointers_rev.data() };
 
 	timer.go();
 #ifdef __SSE4_1__
@@ -178,8 +264,7 @@ list<Hsp> anchored_swipe(Targets& targets, const DP::AnchoredSwipe::Config& cfg)
 	cfg.stats.inc(Statistics::TIME_SW, timer.microseconds());
 
 	timer.go();
-	sort(target_vec.int8.begin(), target_vec.int8.end(), DP::AnchoredSwipe::Target<int8_t>::cmp_target_idx);
-	sort(target_vec.int16.begin(), target_vec.int16.end(), DP::AnchoredSwipe::Target<int16_t>::cmp_target_idx);
+	sort_by_target_idx(target_vec.int16, ctx.buffer);
 	cfg.stats.inc(Statistics::TIME_ANCHORED_SWIPE_SORT, timer.microseconds());
 
 	timer.go();
@@ -236,6 +321,8 @@ list<Hsp> anchored_swipe(Targets& targets, const DP::AnchoredSwipe::Config& cfg)
 	return out;
 }
 
+#endif
+
 }
 
 DISPATCH_2(std::list<Hsp>, anchored_swipe, Targets&, targets, const DP::AnchoredSwipe::Config&, cfg)
@@ -123,6 +123,12 @@ struct Matrix
 	{
 		return ColumnIterator(&hgap_[offset], &score_[offset]);
 	}
+	void set_zero(int begin, int end) {
+		for (int i = begin; i < end; ++i) {
+			score_[i] = Sv();
+			hgap_[i] = Sv();
+		}
+	}
 	int band() const {
 		return band_;
 	}
@@ -413,6 +419,7 @@ struct TracebackVectorMatrix
 	}
 
 	TracebackVectorMatrix(int band, size_t cols) :
+		trace_mask_(trace_pool()),
 		band_(band)
 	{
 		hgap_.resize(band + 1);
@@ -435,12 +442,22 @@ struct TracebackVectorMatrix
 		return _sv();
 	}
 
+	// The direction bitmaps are pooled per thread, allocations beyond the pool cap are not kept for later targets.
+	static MemBuffer<TraceMask>& trace_pool() {
+		thread_local MemBuffer<TraceMask> pool;
+		return pool;
+	}
+
+	~TracebackVectorMatrix() {
+		trace_mask_.shrink(size_t(config.max_trace_pool) / sizeof(TraceMask));
+	}
+
 #if defined(__APPLE__) || !defined(USE_TLS)
 	MemBuffer<_sv> hgap_, score_;
 #else
 	static thread_local MemBuffer<_sv> hgap_, score_;
 #endif
-	MemBuffer<TraceMask> trace_mask_;
+	MemBuffer<TraceMask>& trace_mask_;
 private:
 	int band_;
 };
@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <algorithm>
 #include <utility>
 #include <list>
+#include <type_traits>
 #include <limits.h>
 #include "../dp.h"
 #include "swipe.h"
@@ -186,6 +187,33 @@ Hsp traceback(_cbs bias_correction, const TracebackVectorMatrix<_sv> &dp, const
     out.approx_id = out.approx_id_percent(p.query, target.seq);
 	return out;
 }
+// Returns true if any channel of v scores above the X-drop threshold.
+template<typename Sv>
+FORCE_INLINE bool xdrop_live(const Sv& v, const Sv& threshold, const uint64_t dead_mask) {
+	return (uint64_t)cmp_mask(max(v, threshold), threshold) != dead_mask;
+}
+
+FORCE_INLINE bool xdrop_live(const int32_t v, const int32_t threshold, const uint64_t) {
+	return v > threshold;
+}
+
+template<typename M>
+static void zero_rows(M&, int, int) {}
+
+template<typename Sv>
+static void zero_rows(Matrix<Sv>& dp, int begin, int end) {
+	dp.set_zero(begin, end);
+}
+
+template<typename Sv>
+FORCE_INLINE uint64_t xdrop_dead_mask(const Sv& threshold) {
+	return (uint64_t)cmp_mask(threshold, threshold);
+}
+
+FORCE_INLINE uint64_t xdrop_dead_mask(const int32_t) {
+	return 0;
+}
+
 template<typename _sv, typename _cbs, typename Cfg>
 list<Hsp> swipe(const vector<DpTarget>::const_iterator subject_begin, const vector<DpTarget>::const_iterator subject_end, _cbs composition_bias, vector<DpTarget> &overflow, Params& p)
 {
@@ -227,13 +255,13 @@ list<Hsp> swipe(const vector<DpTarget>::const_iterator subject_begin, const vect
 	::DISPATCH_ARCH::TargetIterator<Score> targets(subject_begin, subject_end, i1, qlen, d_begin);
 	Matrix dp(band, targets.cols);
 
-	const uint32_t cbs_mask = targets.cbs_mask();
+	const uint64_t cbs_mask = targets.cbs_mask();
 	const Score go = score_matrix.gap_open() + score_matrix.gap_extend(), go_s = go * (Score)config.cbs_matrix_scale,
 		ge = score_matrix.gap_extend(), ge_s = ge * (Score)config.cbs_matrix_scale;
 	const _sv open_penalty = blend_sv<_sv>(go, go_s, cbs_mask),
 		extend_penalty = blend_sv<_sv>(ge, ge_s, cbs_mask);
 	SwipeProfile<_sv> profile;
-	array<const int8_t*, 32> target_scores;
+	array<const int8_t*, std::max(CHANNELS, 32)> target_scores;
 
 	Score best[CHANNELS];
 	int max_col[CHANNELS], max_band_row[CHANNELS];
@@ -243,15 +271,48 @@ list<Hsp> swipe(const vector<DpTarget>::const_iterator subject_begin, const vect
 	std::fill(max_band_row, max_band_row + CHANNELS, 0);
 	CBSBuffer<_sv, _cbs> cbs_buf(composition_bias, qlen, cbs_mask);
 
+	// Adaptive band for score-only alignments: once every target has scored above the X-drop, band rows whose cells
+	// fall below the best score minus the X-drop in all channels are no longer computed. The computed rows follow the
+	// live cells of the previous column and extend downwards as long as a vertical gap is still live.
+	const int xdrop = std::is_same<Cell, _sv>::value && !Cfg::traceback ? config.swipe_xdrop : 0;
+	int live_begin = 0, live_end = band, computed_begin = 0, computed_end = band;
+
 	int j = 0;
 	while (targets.active.size() > 0) {
 		const int i0_ = std::max(i0, 0), i1_ = std::min(i1, qlen - 1) + 1, band_offset = i0_ - i0;
 		if (i0_ >= i1_)
 			break;
-		typename Matrix::ColumnIterator it(dp.begin(band_offset, j));
+		int row_begin = band_offset, stop_row = band;
+		_sv xdrop_threshold = _sv();
+		uint64_t dead_mask = 0;
+		bool prune = false;
+		if (xdrop > 0) {
+			alignas(64) Score threshold[CHANNELS];
+			std::fill(threshold, threshold + CHANNELS, ScoreTraits<_sv>::max_score());
+			prune = true;
+			for (int i = 0; i < targets.active.size(); ++i) {
+				const int channel = targets.active[i];
+				if (ScoreTraits<_sv>::int_score(best[channel]) <= xdrop) {
+					threshold[channel] = ScoreTraits<_sv>::zero_score();
+					prune = false;
+				}
+				else
+					threshold[channel] = best[channel] - (Score)xdrop;
+			}
+			xdrop_threshold = load_sv<_sv>(threshold);
+			dead_mask = xdrop_dead_mask(xdrop_threshold);
+			if (prune) {
+				if (live_end <= live_begin)
+					break;
+				row_begin = std::max(row_begin, live_begin - 1);
+				stop_row = live_end;
+			}
+		}
+		int new_live_begin = band, new_live_end = 0, row_end = row_begin;
+		typename Matrix::ColumnIterator it(dp.begin(row_begin, j));
 		Cell vgap = Cell(), hgap = Cell();
 		_sv col_best = _sv();
-		RowCounter row_counter(band_offset);
+		RowCounter row_counter(row_begin);
 
 		if (band_offset > 0)
 			it.set_zero();
@@ -275,20 +336,23 @@ list<Hsp> swipe(const vector<DpTarget>::const_iterator subject_begin, const vect
 		const uint64_t live = targets.live();
 #endif
 
+		bool stopped = false;
 #ifdef STRICT_BAND
-		for (int part = 0; part < band_parts.count(); ++part) {
-			const int i_begin = std::max(i0 + band_parts.begin(part), i0_);
+		for (int part = 0; part < band_parts.count() && !stopped; ++part) {
+			const int i_begin = std::max(i0 + band_parts.begin(part), i0 + row_begin);
 			const int i_end = std::min(i0 + band_parts.end(part), i1_);
 			const _sv target_mask = load_sv<_sv>(band_parts.mask(part));
 			vgap += target_mask;
-#ifdef DP_STAT
-			p.stat.inc(Statistics::GROSS_DP_CELLS, uint64_t(i_end - i_begin) * CHANNELS);
-			p.stat.inc(Statistics::NET_DP_CELLS, uint64_t(i_end - i_begin) * popcount64(live & band_parts.bit_mask(part)));
-#endif
-			for (int i = i_begin; i < i_end; ++i) {
+			int i = i_begin;
+			for (; i < i_end; ++i) {
 #else
-			for (int i = i0_; i < i1_; ++i) {
+			int i = i0 + row_begin;
+			for (; i < i1_; ++i) {
 #endif
+				if (prune && i - i0 >= stop_row && !xdrop_live(static_cast<_sv>(vgap), xdrop_threshold, dead_mask)) {
+					stopped = true;
+					break;
+				}
 				hgap = it.hgap();
 				auto stat_h = it.hstat();
 				_sv match_scores = profile.get(p.query[i]);
@@ -305,11 +369,34 @@ list<Hsp> swipe(const vector<DpTarget>::const_iterator subject_begin, const vect
 				it.set_hgap(hgap);
 				it.set_score(next);
 				++it;
+				if (xdrop > 0 && xdrop_live(static_cast<_sv>(next), xdrop_threshold, dead_mask)) {
+					new_live_begin = std::min(new_live_begin, i - i0);
+					new_live_end = i - i0 + 1;
+				}
 			}
 #ifdef STRICT_BAND
+			if (i > i_begin)
+				row_end = i - i0;
+#ifdef DP_STAT
+			if (i > i_begin) {
+				p.stat.inc(Statistics::GROSS_DP_CELLS, uint64_t(i - i_begin) * CHANNELS);
+				p.stat.inc(Statistics::NET_DP_CELLS, uint64_t(i - i_begin) * popcount64(live & band_parts.bit_mask(part)));
+			}
+#endif
 		}
+#else
+			row_end = i - i0;
 #endif
 
+		if (xdrop > 0) {
+			zero_rows(dp, computed_begin, std::min(row_begin, computed_end));
+			zero_rows(dp, std::max(row_end, computed_begin), computed_end);
+			computed_begin = row_begin;
+			computed_end = row_end;
+			live_begin = new_live_begin;
+			live_end = new_live_end;
+		}
+
 		Score col_best_[CHANNELS], i_max[CHANNELS];
 		store_sv(col_best, col_best_);
 		row_counter.store(i_max);
@@ -84,6 +84,9 @@ struct Matrix
 	Sv operator[](int i) const {
 		return score_[i + 1];
 	}
+	Sv hgap(int i) const {
+		return hgap_[i];
+	}
 private:
 #if defined(__APPLE__) || !defined(USE_TLS)
 	MemBuffer<Sv> hgap_, score_;
@@ -207,6 +210,7 @@ struct TracebackVectorMatrix
 	}
 
 	TracebackVectorMatrix(int rows, int cols) :
+		trace_mask_(trace_pool()),
 		rows_(rows),
 		cols_(cols)
 	{
@@ -240,12 +244,22 @@ struct TracebackVectorMatrix
 		return Sv();
 	}
 
+	// The direction bitmaps are pooled per thread, allocations beyond the pool cap are not kept for later targets.
+	static MemBuffer<TraceMask>& trace_pool() {
+		thread_local MemBuffer<TraceMask> pool;
+		return pool;
+	}
+
+	~TracebackVectorMatrix() {
+		trace_mask_.shrink(size_t(config.max_trace_pool) / sizeof(TraceMask));
+	}
+
 #if defined(__APPLE__) || !defined(USE_TLS)
 	MemBuffer<Sv> hgap_, score_;
 #else
 	static thread_local MemBuffer<Sv> hgap_, score_;
 #endif
-	MemBuffer<TraceMask> trace_mask_;
+	MemBuffer<TraceMask>& trace_mask_;
 private:
 	int rows_, cols_;
 };
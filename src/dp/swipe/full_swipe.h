@@ -20,9 +20,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ****/
 
 #include <vector>
+#include <memory>
+#include <algorithm>
 #include "swipe.h"
 #include "../../basic/sequence.h"
 #include "target_iterator.h"
+#include "striped.h"
 #include "../../util/data_structures/mem_buffer.h"
 
 using std::vector;
@@ -123,6 +126,64 @@ Hsp traceback(_cbs bias_correction, const TracebackVectorMatrix<_sv> &dp, const
 	return out;
 }
 
+// Continues the score-only 8 bit alignment of a target that may saturate in the next column in 16 bit precision,
+// starting from the current column of the lane, so that the lane can be refilled without recomputing the target.
+template<typename _sv, typename Matrix, typename RowCounter>
+struct LanePromotion {
+	LanePromotion(const Params&) {}
+	bool operator()(const Matrix&, int, int, const DpTarget&, Loc, Params&, std::pair<int, Loc>&) {
+		return false;
+	}
+};
+
+#if defined(__SSE2__) && defined(__SSE4_1__)
+
+template<>
+struct LanePromotion<ScoreVector<int8_t, SCHAR_MIN>, Matrix<ScoreVector<int8_t, SCHAR_MIN>>, DummyRowCounter<ScoreVector<int8_t, SCHAR_MIN>>> {
+
+	using Sv = ScoreVector<int8_t, SCHAR_MIN>;
+
+	// A column maximum can exceed the maximum of the previous column by at most the highest substitution score.
+	LanePromotion(const Params& p):
+		threshold(ScoreTraits<Sv>::max_int_score() - score_matrix.high_score() - max_bias(p))
+	{}
+
+	bool operator()(const Matrix<Sv>& dp, int channel, int col_best, const DpTarget& target, Loc j, Params& p, std::pair<int, Loc>& r) {
+		if (col_best < threshold || target.adjusted_matrix() || target.carry_over.i1 != 0 || j + 1 >= target.seq.length())
+			return false;
+		const Loc qlen = p.query.length();
+		if (!profile) {
+			profile.reset(new StripedProfile(p.query, p.composition_bias));
+			h.resize(qlen);
+			e.resize(qlen);
+		}
+		for (Loc i = 0; i < qlen; ++i) {
+			h[i] = (int16_t)ScoreTraits<Sv>::int_score(extract_channel(dp[i], channel));
+			e[i] = (int16_t)ScoreTraits<Sv>::int_score(extract_channel(dp.hgap(i), channel));
+		}
+		r = striped_score(*profile, target.seq, j + 1, h.data(), e.data());
+#ifdef DP_STAT
+		p.stat.inc(Statistics::GROSS_DP_CELLS, uint64_t(qlen) * (target.seq.length() - j - 1));
+#endif
+		p.stat.inc(Statistics::EXT_PROMOTED_8);
+		return true;
+	}
+
+private:
+
+	static int max_bias(const Params& p) {
+		const Loc qlen = p.query.length();
+		return p.composition_bias && qlen > 0 ? std::max((int)*std::max_element(p.composition_bias, p.composition_bias + qlen), 0) : 0;
+	}
+
+	const int threshold;
+	std::unique_ptr<StripedProfile> profile;
+	std::vector<int16_t> h, e;
+
+};
+
+#endif
+
 template<typename _sv, typename _cbs, typename It, typename Cfg>
 list<Hsp> swipe(const It target_begin, const It target_end, std::atomic<BlockId>* const next, _cbs composition_bias, vector<DpTarget>& overflow, Params& p)
 {
@@ -150,10 +211,12 @@ list<Hsp> swipe(const It target_begin, const It target_end, std::atomic<BlockId>
 	StatType hsp_stats[CHANNELS];
 	std::fill(best, best + CHANNELS, ScoreTraits<_sv>::zero_score());
 	SwipeProfile<_sv> profile;
-	std::array<const int8_t*, 32> target_scores;
+	std::array<const int8_t*, std::max(CHANNELS, 32)> target_scores;
 	AsyncTargetBuffer<Score, It> targets(target_begin, target_end, next);
 	Matrix dp(qlen, targets.max_len());
 	CBSBuffer<_sv, _cbs> cbs_buf(composition_bias, qlen, 0);
+	LanePromotion<_sv, Matrix, RowCounter> promote(p);
+	std::pair<int, Loc> promoted;
 	list<Hsp> out;
 	int col = 0;
 	
@@ -216,6 +279,18 @@ list<Hsp> swipe(const It target_begin, const It target_end, std::atomic<BlockId>
 			if (col_best_[c] == ScoreTraits<_sv>::max_score()) {
 				overflow.push_back(targets.dp_targets[c]);
 				reinit = true;
+			} else if (promote(dp, c, ScoreTraits<_sv>::int_score(col_best_[c]), targets.dp_targets[c], targets.pos[c], p, promoted)) {
+				const DpTarget& t = targets.dp_targets[c];
+				const int best_score = ScoreTraits<_sv>::int_score(best[c]);
+				if (promoted.first >= SHRT_MAX)
+					overflow.push_back(t);
+				else {
+					const int s = std::max(promoted.first, best_score) * config.cbs_matrix_scale;
+					const double evalue = score_matrix.evalue(s, qlen, (unsigned)t.true_target_len);
+					if (s > 0 && score_matrix.report_cutoff(s, evalue))
+						out.push_back(score_only_hsp(t, t.target_idx, s, evalue, promoted.first > best_score ? promoted.second : max_j[c], p));
+				}
+				reinit = true;
 			} else if (!targets.inc(c)) {
 				if (overflow_stats<_sv>(hsp_stats[c]))
 					overflow.push_back(targets.dp_targets[c]);
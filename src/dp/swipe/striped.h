@@ -0,0 +1,188 @@
+/****
+DIAMOND protein aligner
+Copyright (C) 2022 Max Planck Society for the Advancement of Science e.V.
+
+Code developed by Benjamin Buchfink <benjamin.buchfink@tue.mpg.de>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****/
+
+#pragma once
+#include <list>
+#include <vector>
+#include <utility>
+#include <limits.h>
+#include "../dp.h"
+#include "../score_profile.h"
+#include "../../util/simd.h"
+#include "../../util/memory/alignment.h"
+
+namespace DP { namespace Swipe { namespace DISPATCH_ARCH {
+
+// Builds the HSP reported by the score-only SWIPE kernel for a target whose best score ends at target position max_j.
+static inline Hsp score_only_hsp(const DpTarget& target, BlockId swipe_target, int score, double evalue, Loc max_j, Params& p) {
+	Hsp hsp(false);
+	hsp.swipe_target = swipe_target;
+	hsp.score = score;
+	hsp.evalue = evalue;
+	hsp.bit_score = score_matrix.bitscore(score);
+	hsp.corrected_bit_score = score_matrix.bitscore_corrected(score, p.query.length(), target.true_target_len);
+	hsp.frame = p.frame.index();
+	hsp.query_range.end_ = 1;
+	hsp.subject_range.end_ = max_j + 1;
+	hsp.target_seq = target.seq;
+	hsp.matrix = target.matrix;
+	hsp.query_source_range = TranslatedPosition::absolute_interval(TranslatedPosition(hsp.query_range.begin_, p.frame), TranslatedPosition(hsp.query_range.end_, p.frame), p.query_source_len);
+	hsp.subject_source_range = hsp.subject_range;
+	return hsp;
+}
+
+#ifdef __SSE2__
+
+// Striped query profile (Farrar 2007) in 16 bit precision. Lane k of segment s holds the score of query position
+// k * seg_len + s, positions past the end of the query are padded with a large negative score.
+struct StripedProfile {
+
+	enum { LANES = 8 };
+	static constexpr int16_t PADDING_SCORE = SHRT_MIN / 2;
+
+	StripedProfile(Sequence query, const int8_t* cbs) :
+		qlen(query.length()),
+		seg_len((query.length() + LANES - 1) / LANES),
+		data(AMINO_ACID_COUNT * seg_len * LANES)
+	{
+		const LongScoreProfile<int16_t> profile = make_profile16(query, nullptr, 0);
+		for (int l = 0; l < AMINO_ACID_COUNT; ++l) {
+			const int16_t* scores = profile.get(Letter(l), 0);
+			int16_t* out = &data[l * seg_len * LANES];
+			for (int s = 0; s < seg_len; ++s)
+				for (int k = 0; k < LANES; ++k) {
+					const Loc i = k * seg_len + s;
+					out[s * LANES + k] = i < qlen ? int16_t(scores[i] + (cbs ? cbs[i] : 0)) : PADDING_SCORE;
+				}
+		}
+	}
+
+	const __m128i* get(Letter l) const {
+		return reinterpret_cast<const __m128i*>(&data[(int)l * seg_len * LANES]);
+	}
+
+	const Loc qlen;
+	const int seg_len;
+	std::vector<int16_t, Util::Memory::AlignmentAllocator<int16_t, 16>> data;
+
+};
+
+// Computes the local alignment score of the query against the target using the striped algorithm with lazy F loop.
+// Returns the best score and the target position of the first column attaining it. A score of SHRT_MAX indicates
+// saturation. The computation may be resumed at target position begin from the scores and horizontal gap scores of the
+// previous column, given in query order.
+static inline std::pair<int, Loc> striped_score(const StripedProfile& profile, const Sequence& target, Loc begin = 0, const int16_t* h_init = nullptr, const int16_t* e_init = nullptr) {
+	const int seg_len = profile.seg_len;
+	const __m128i zero = _mm_setzero_si128(),
+		vmin = _mm_set1_epi16(SHRT_MIN),
+		lane0_min = _mm_set_epi16(0, 0, 0, 0, 0, 0, 0, SHRT_MIN),
+		open = _mm_set1_epi16(score_matrix.gap_open() + score_matrix.gap_extend()),
+		extend = _mm_set1_epi16(score_matrix.gap_extend());
+	using Buffer = std::vector<int16_t, Util::Memory::AlignmentAllocator<int16_t, 16>>;
+	Buffer h_load_buf(seg_len * StripedProfile::LANES, 0), h_store_buf(seg_len * StripedProfile::LANES, 0), e_buf(seg_len * StripedProfile::LANES, SHRT_MIN);
+	__m128i* h_load = reinterpret_cast<__m128i*>(h_load_buf.data()), * h_store = reinterpret_cast<__m128i*>(h_store_buf.data()), * e = reinterpret_cast<__m128i*>(e_buf.data());
+	if (h_init) {
+		const Loc qlen = profile.qlen;
+		for (int s = 0; s < seg_len; ++s)
+			for (int k = 0; k < StripedProfile::LANES; ++k) {
+				const Loc i = k * seg_len + s;
+				if (i < qlen) {
+					h_load_buf[s * StripedProfile::LANES + k] = h_init[i];
+					e_buf[s * StripedProfile::LANES + k] = e_init[i];
+				}
+			}
+	}
+	int best = 0;
+	Loc best_j = begin;
+
+	for (Loc j = begin; j < target.length(); ++j) {
+		const __m128i* scores = profile.get(letter_mask(target[j]));
+		__m128i vf = vmin, vmax = zero, vh = _mm_slli_si128(h_load[seg_len - 1], 2);
+
+		for (int i = 0; i < seg_len; ++i) {
+			vh = _mm_adds_epi16(vh, scores[i]);
+			const __m128i ve = e[i];
+			vh = _mm_max_epi16(vh, ve);
+			vh = _mm_max_epi16(vh, vf);
+			vh = _mm_max_epi16(vh, zero);
+			vmax = _mm_max_epi16(vmax, vh);
+			h_store[i] = vh;
+			vh = _mm_subs_epi16(vh, open);
+			e[i] = _mm_max_epi16(_mm_subs_epi16(ve, extend), vh);
+			vf = _mm_max_epi16(_mm_subs_epi16(vf, extend), vh);
+			vh = h_load[i];
+		}
+
+		// Cells reached by vertical gaps across segment boundaries. These cannot exceed the column maximum, but may
+		// open horizontal gaps into the next column.
+		vf = _mm_or_si128(_mm_slli_si128(vf, 2), lane0_min);
+		int i = 0;
+		while (_mm_movemask_epi8(_mm_cmpgt_epi16(vf, _mm_subs_epi16(h_store[i], open))) != 0) {
+			vh = _mm_max_epi16(h_store[i], vf);
+			h_store[i] = vh;
+			e[i] = _mm_max_epi16(e[i], _mm_subs_epi16(vh, open));
+			vf = _mm_subs_epi16(vf, extend);
+			if (++i == seg_len) {
+				i = 0;
+				vf = _mm_or_si128(_mm_slli_si128(vf, 2), lane0_min);
+			}
+		}
+		std::swap(h_load, h_store);
+
+		vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 8));
+		vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 4));
+		vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 2));
+		const int col_best = (int16_t)_mm_extract_epi16(vmax, 0);
+		if (col_best > best) {
+			best = col_best;
+			best_j = j;
+		}
+		if (best == SHRT_MAX)
+			break;
+	}
+	return { best, best_j };
+}
+
+// Score-only full matrix alignment of the query against each target. Produces the same HSPs as the score-only SWIPE
+// kernel, saturated targets are moved to the overflow list.
+static inline std::list<Hsp> striped_swipe(const std::vector<DpTarget>::const_iterator begin, const std::vector<DpTarget>::const_iterator end, std::vector<DpTarget>& overflow, Params& p) {
+	const StripedProfile profile(p.query, p.composition_bias);
+	const Loc qlen = p.query.length();
+	std::list<Hsp> out;
+	for (auto it = begin; it != end; ++it) {
+		const std::pair<int, Loc> r = striped_score(profile, it->seq);
+#ifdef DP_STAT
+		p.stat.inc(Statistics::GROSS_DP_CELLS, uint64_t(qlen) * it->seq.length());
+#endif
+		if (r.first >= SHRT_MAX) {
+			overflow.push_back(*it);
+			continue;
+		}
+		const int s = r.first * config.cbs_matrix_scale;
+		const double evalue = score_matrix.evalue(s, qlen, (unsigned)it->true_target_len);
+		if (s > 0 && score_matrix.report_cutoff(s, evalue))
+			out.push_back(score_only_hsp(*it, it->blank() ? BlockId(it - begin) : it->target_idx, s, evalue, r.second, p));
+	}
+	return out;
+}
+
+#endif
+
+}}}
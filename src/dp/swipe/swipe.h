@@ -38,7 +38,7 @@ namespace DP {
 
 template<typename _sv, typename _cbs>
 struct CBSBuffer {
-	CBSBuffer(const DP::NoCBS&, int, uint32_t) {}
+	CBSBuffer(const DP::NoCBS&, int, uint64_t) {}
 	void* operator()(int i) const {
 		return nullptr;
 	}
@@ -46,7 +46,7 @@ struct CBSBuffer {
 
 template<typename _sv>
 struct CBSBuffer<_sv, const int8_t*> {
-	CBSBuffer(const int8_t* v, int l, uint32_t channel_mask) {
+	CBSBuffer(const int8_t* v, int l, uint64_t channel_mask) {
 		typedef typename ::DISPATCH_ARCH::ScoreTraits<_sv>::Score Score;
 		data.reserve(l);
 		for (int i = 0; i < l; ++i)
@@ -55,7 +55,7 @@ struct CBSBuffer<_sv, const int8_t*> {
 	_sv operator()(int i) const {
 		return data[i];
 	}
-	std::vector<_sv, Util::Memory::AlignmentAllocator<_sv, 32>> data;
+	std::vector<_sv, Util::Memory::AlignmentAllocator<_sv, 64>> data;
 };
 
 template<typename _sv>
@@ -107,7 +107,16 @@ struct SwipeProfile
 	}
 
 	void set(const int8_t** target_scores) {
-#if ARCH_ID == 2
+#if ARCH_ID == 3
+		alignas(32) int8_t buf[32 * 32];
+		for (int k = 0; k < ScoreTraits<Sv>::CHANNELS; k += 32) {
+			transpose(target_scores + k, 32, buf, __m256i());
+			for (size_t i = 0; i < AMINO_ACID_COUNT; ++i)
+				memcpy((int8_t*)&data_[i] + k, buf + i * 32, 32);
+		}
+		for (size_t i = 0; i < AMINO_ACID_COUNT; ++i)
+			data_[i].expand_from_8bit();
+#elif ARCH_ID == 2
 		transpose(target_scores, 32, (int8_t*)data_, __m256i());
 		for (size_t i = 0; i < AMINO_ACID_COUNT; ++i)
 			data_[i].expand_from_8bit();
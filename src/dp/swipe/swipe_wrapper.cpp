@@ -36,6 +36,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "full_matrix.h"
 #include "full_swipe.h"
 #include "banded_swipe.h"
+#include "striped.h"
 #include "../../util/geo/geo.h"
 #include "../../util/simd/dispatch.h"
 
@@ -306,6 +307,30 @@ static list<Hsp> swipe_threads(const It begin, const It end, vector<DpTarget> &o
 	return hsp;
 }
 
+// Minimum query length and maximum SWIPE lane occupancy (in percent) for using the striped kernel.
+static const Loc STRIPED_MIN_QUERY_LEN = 4096;
+static const ptrdiff_t STRIPED_MAX_OCCUPANCY = 25;
+
+static bool striped(const unsigned bin, const vector<DpTarget>::const_iterator begin, const vector<DpTarget>::const_iterator end, list<Hsp>& out, vector<DpTarget>& overflow, Params& p) {
+#ifdef __SSE2__
+	const ptrdiff_t channels = ::DISPATCH_ARCH::ScoreTraits<::DISPATCH_ARCH::ScoreVector<int16_t, SHRT_MIN>>::CHANNELS * (bin == 0 ? 2 : 1);
+	if (bin > 1 || p.v != HspValues::NONE || !flag_any(p.flags, Flags::FULL_MATRIX) || flag_any(p.flags, Flags::SEMI_GLOBAL)
+		|| p.query.length() < STRIPED_MIN_QUERY_LEN || (end - begin) * 100 > channels * STRIPED_MAX_OCCUPANCY)
+		return false;
+	for (auto i = begin; i != end; ++i)
+		if (i->adjusted_matrix() || i->carry_over.i1 != 0)
+			return false;
+	out = Swipe::DISPATCH_ARCH::striped_swipe(begin, end, overflow, p);
+	return true;
+#else
+	return false;
+#endif
+}
+
+static bool striped(const unsigned bin, const SequenceSet::ConstIterator begin, const SequenceSet::ConstIterator end, list<Hsp>& out, vector<DpTarget>& overflow, Params& p) {
+	return false;
+}
+
 template<typename It>
 static pair<list<Hsp>, vector<DpTarget>> swipe_bin(const unsigned bin, const It begin, const It end, const int round, Params& p) {
 	if (end - begin == 0)
@@ -317,6 +342,10 @@ static pair<list<Hsp>, vector<DpTarget>> swipe_bin(const unsigned bin, const It
 		sort(begin, end);
 	p.stat.inc(Statistics::value(Statistics::EXT8 + bin), end - begin);
 	TaskTimer timer;
+	if (striped(bin, begin, end, out, overflow, p)) {
+		p.stat.inc(time_stat, timer.microseconds());
+		return { out, overflow };
+	}
 	switch (bin) {
 #if defined(__SSE4_1__) | defined(__ARM_NEON)
 	case 0:
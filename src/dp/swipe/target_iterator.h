@@ -122,7 +122,7 @@ struct TargetIterator
 
 	const int8_t** get(const int8_t** target_scores) const {
 		static const int8_t blank[32] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-		std::fill(target_scores, target_scores + 32, blank);
+		std::fill(target_scores, target_scores + std::max((int)CHANNELS, 32), blank);
 		for (int i = 0; i < active.size(); ++i) {
 			const int channel = active[i];
 			const int l = (int)(*this)[channel];
@@ -164,11 +164,11 @@ struct TargetIterator
 		return true;
 	}
 
-	uint32_t cbs_mask() const {
-		uint32_t r = 0;
+	uint64_t cbs_mask() const {
+		uint64_t r = 0;
 		for (uint32_t i = 0; i < (uint32_t)n_targets; ++i)
 			if (subject_begin[i].adjusted_matrix())
-				r |= 1 << i;
+				r |= (uint64_t)1 << i;
 		return r;
 	}
 
@@ -233,7 +233,7 @@ struct AsyncTargetBuffer
 
 	const int8_t** get(const int8_t** target_scores) const {
 		static const int8_t blank[32] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-		std::fill(target_scores, target_scores + 32, blank);
+		std::fill(target_scores, target_scores + std::max((int)CHANNELS, 32), blank);
 		for (int i = 0; i < active.size(); ++i) {
 			const int channel = active[i];
 			const int l = (int)(*this)[channel];
@@ -279,13 +279,13 @@ struct AsyncTargetBuffer
 		return true;
 	}
 
-	uint32_t cbs_mask() {
-		uint32_t r = 0;
+	uint64_t cbs_mask() {
+		uint64_t r = 0;
 		custom_matrix_16bit = false;
 		for (int i = 0; i < active.size(); ++i) {
 			const int channel = active[i];
 			if (dp_targets[channel].adjusted_matrix()) {
-				r |= 1 << channel;
+				r |= (uint64_t)1 << channel;
 				if (dp_targets[channel].matrix->score_max > SCHAR_MAX || dp_targets[channel].matrix->score_min < SCHAR_MIN)
 					custom_matrix_16bit = true;
 			}
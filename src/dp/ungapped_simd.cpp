@@ -18,7 +18,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <assert.h>
 #include <algorithm>
+#include <limits.h>
 #include "score_vector_int8.h"
+#include "score_vector_int16.h"
+#include "../basic/config.h"
 #include "../util/simd/vector.h"
 #include "ungapped_simd.h"
 #include "../util/simd/transpose.h"
@@ -75,7 +78,7 @@ void window_ungapped_best(const Letter* query, const Letter** subjects, int subj
 #if defined(__SSE4_1__) | defined(__aarch64__)
 	}
 #endif
-#if ARCH_ID == 2
+#if ARCH_ID == 2 || ARCH_ID == 3
 	//else if (subject_count <= 16)
 		//::DP::ARCH_SSE4_1::window_ungapped(query, subjects, subject_count, window, out);
 	else
@@ -85,9 +88,128 @@ void window_ungapped_best(const Letter* query, const Letter** subjects, int subj
 #endif
 }
 
+
+#ifdef __SSE4_1__
+
+// Ungapped x-drop extension of up to CHANNELS anchors in 16 bit precision, one anchor per channel. The channels share
+// the query position, a channel is masked while the extension has not yet reached its anchor. Channels whose score may
+// have saturated are recomputed by the scalar function.
+static void xdrop_ungapped_channels(const Sequence& query, const int8_t* query_cbs, const Sequence& subject, const Loc* qa, const Loc* sa, int count, bool count_identities, DiagonalSegment* out) {
+	using Sv = ScoreVector<int16_t, 0>;
+	constexpr int CHANNELS = ScoreTraits<Sv>::CHANNELS;
+	constexpr int MAX_SCORE = SHRT_MAX - 256;
+	assert(count <= CHANNELS);
+
+	alignas(64) int16_t buf[CHANNELS], letters[CHANNELS];
+	Loc diag[CHANNELS];
+	Loc q_min = qa[0], q_max = qa[0];
+	for (int k = 0; k < CHANNELS; ++k) {
+		buf[k] = k < count ? (int16_t)qa[k] : 0;
+		letters[k] = DELIMITER_LETTER;
+	}
+	for (int k = 0; k < count; ++k) {
+		diag[k] = qa[k] - sa[k];
+		q_min = std::min(q_min, qa[k]);
+		q_max = std::max(q_max, qa[k]);
+	}
+	const Sv zero, one(1), xdrop(config.raw_ungapped_xdrop), delimiter((int)DELIMITER_LETTER), letter_mask_v((int)LETTER_MASK), qa_v(buf);
+	const uint32_t none = cmp_mask(zero, zero);
+	int16_t valid[CHANNELS];
+	for (int k = 0; k < CHANNELS; ++k)
+		valid[k] = k < count ? -1 : 0;
+	const Sv valid_v(valid);
+	Sv score, st, ident, id_n, alive, best_begin, best_end;
+	const Loc slen = subject.length();
+
+	// Runs one step of the extension at query position q, returns false if all channels have terminated.
+	auto step = [&](Loc q, const Sv& started, Sv& best) {
+		const Letter ql = query[q];
+		for (int k = 0; k < count; ++k)
+			letters[k] = subject[std::min(std::max(q - diag[k], -1), slen)];
+		const Sv sl(letters);
+		Sv cont = blend(xdrop > score - st, zero, sl == delimiter);
+		if (ql == DELIMITER_LETTER)
+			cont = zero;
+		Sv alive_cont = alive;
+		alive_cont &= cont;
+		alive = blend(alive, alive_cont, started);
+		if (cmp_mask(alive, zero) == none)
+			return false;
+		Sv active = alive;
+		active &= started;
+		Sv masked = sl;
+		masked &= letter_mask_v;
+		Sv match(unsigned(letter_mask(ql)), masked.data_);
+		if (query_cbs)
+			match += Sv((int)query_cbs[q]);
+		st = blend(st, st + match, active);
+		Sv improved = st > score;
+		improved &= active;
+		score = blend(score, st, improved);
+		best = blend(best, Sv((int)q), improved);
+		if (count_identities) {
+			Sv eq = sl == Sv((int)ql);
+			eq &= active;
+			id_n -= eq;
+			Sv n = id_n;
+			n &= improved;
+			ident += n;
+			id_n = blend(id_n, zero, improved);
+		}
+		return true;
+	};
+
+	alive = valid_v;
+	best_begin = qa_v;
+	for (Loc q = q_max - 1; step(q, qa_v > Sv((int)q), best_begin); --q);
+
+	const Sv qa_last = qa_v - one;
+	st = score;
+	alive = valid_v;
+	id_n = zero;
+	best_end = qa_last;
+	for (Loc q = q_min; step(q, Sv((int)q) > qa_last, best_end); ++q);
+
+	alignas(64) int16_t scores[CHANNELS], begins[CHANNELS], ends[CHANNELS], idents[CHANNELS];
+	score.store(scores);
+	best_begin.store(begins);
+	best_end.store(ends);
+	ident.store(idents);
+	for (int k = 0; k < count; ++k) {
+		if (scores[k] >= MAX_SCORE)
+			out[k] = ::xdrop_ungapped(query, query_cbs, subject, qa[k], sa[k], count_identities);
+		else
+			out[k] = DiagonalSegment(begins[k], begins[k] - diag[k], ends[k] - begins[k] + 1, scores[k], count_identities ? idents[k] : 0);
+	}
+}
+
+#endif
+
+void xdrop_ungapped(const Sequence& query, const int8_t* query_cbs, const Sequence& subject, const Loc* qa, const Loc* sa, int count, bool count_identities, DiagonalSegment* out) {
+	int k = 0;
+#ifdef __SSE4_1__
+	constexpr int CHANNELS = ScoreTraits<ScoreVector<int16_t, 0>>::CHANNELS, MIN_CHANNELS = 4, MAX_SPREAD = 64;
+	if (query.length() < SHRT_MAX - 1)
+		while (k < count) {
+			int n = 1;
+			while (k + n < count && n < CHANNELS && qa[k + n] - qa[k] <= MAX_SPREAD)
+				++n;
+			if (n >= MIN_CHANNELS)
+				xdrop_ungapped_channels(query, query_cbs, subject, qa + k, sa + k, n, count_identities, out + k);
+			else
+				for (int l = k; l < k + n; ++l)
+					out[l] = ::xdrop_ungapped(query, query_cbs, subject, qa[l], sa[l], count_identities);
+			k += n;
+		}
+#endif
+	for (; k < count; ++k)
+		out[k] = ::xdrop_ungapped(query, query_cbs, subject, qa[k], sa[k], count_identities);
+}
+
 }
 
 DISPATCH_5(void, window_ungapped, const Letter*, query, const Letter**, subjects, int, subject_count, int, window, int*, out);
 DISPATCH_5(void, window_ungapped_best, const Letter*, query, const Letter**, subjects, int, subject_count, int, window, int*, out);
+DISPATCH_8(void, xdrop_ungapped, const Sequence&, query, const int8_t*, query_cbs, const Sequence&, subject, const Loc*, qa, const Loc*, sa, int, count, bool, count_identities, DiagonalSegment*, out);
 
 }
@@ -18,10 +18,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 #include "../basic/value.h"
+#include "../basic/sequence.h"
+#include "../util/geo/diagonal_segment.h"
 
 namespace DP {
 
 void window_ungapped(const Letter* query, const Letter** subjects, int subject_count, int window, int* out);
 void window_ungapped_best(const Letter* query, const Letter** subjects, int subject_count, int window, int* out);
 
+// Ungapped x-drop extensions from the anchors (qa[k], sa[k]), equal to those of xdrop_ungapped. Anchors should be sorted by query position, neighbouring anchors are extended in parallel.
+void xdrop_ungapped(const Sequence& query, const int8_t* query_cbs, const Sequence& subject, const Loc* qa, const Loc* sa, int count, bool count_identities, DiagonalSegment* out);
+
 }
\ No newline at end of file
@@ -34,6 +34,7 @@ Config::Config() :
 	lazy_masking(false),
 	track_aligned_queries(false),
 	lin_stage1_target(false),
+	reduced_fp(config.reduced_fp),
 	max_target_seqs(config.max_target_seqs_.get(25)),
 	db(nullptr),
 	query_file(nullptr),
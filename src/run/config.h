@@ -94,6 +94,8 @@ struct Config {
 	Loc                                        minimizer_window;
 	bool                                       lin_stage1_target;
 	unsigned                                   hamming_filter_id;
+	bool                                       reduced_fp;
+	unsigned                                   reduced_fp_id;
 	double                                     min_length_ratio;
 	double                                     ungapped_evalue;
 	double                                     ungapped_evalue_short;
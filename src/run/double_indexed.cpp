@@ -28,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <memory>
 #include <algorithm>
 #include <cstdio>
+#include <future>
 #include "../data/reference.h"
 #include "../data/queries.h"
 #include "../basic/statistics.h"
@@ -46,6 +47,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../util/parallel/multiprocessing.h"
 #include "../util/parallel/parallelizer.h"
 #include "../util/system/system.h"
+#include "../util/string/string.h"
 #include "../align/target.h"
 #include "../data/seed_set.h"
 #include "../util/data_structures/deque.h"
@@ -55,6 +57,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "config.h"
 #include "../data/seed_array.h"
 #include "../data/fasta/fasta_file.h"
+#include "../stats/cbs.h"
 
 #ifdef WITH_DNA
 #include "../dna/dna_index.h"
@@ -73,6 +76,9 @@ namespace Search {
 static const int64_t MAX_INDEX_QUERY_SIZE = 32 * MEGABYTES;
 static const size_t MAX_HASH_SET_SIZE = 8 * MEGABYTES;
 static const size_t MIN_QUERY_INDEXED_DB_SIZE = 256 * MEGABYTES;
+// Share of the memory limit that a prefetched query block may occupy, and the assumed footprint per letter.
+static const double PIPELINE_MEMORY_SHARE = 0.25;
+static const int64_t PIPELINE_BYTES_PER_LETTER = 4;
 
 static const string label_align = "align";
 static const string stack_align_todo = label_align + "_todo";
@@ -101,15 +107,31 @@ static string get_ref_block_tmpfile_name(size_t query, size_t block) {
 	return join_path(config.parallel_tmpdir, file_name);
 }
 
-static pair<char*, char*> alloc_buffers(Config& cfg) {
+static pair<char*, char*> alloc_buffers(Config& cfg, const SeedArrayIndex* ref_seed_arrays) {
 	if (Search::keep_target_id(cfg))
 		return { SeedArray<PackedLocId>::alloc_buffer(cfg.target->hst(), cfg.index_chunks),
 		config.target_indexed ? nullptr : SeedArray<PackedLocId>::alloc_buffer(cfg.query->hst(), cfg.index_chunks) };
 	else
-		return { SeedArray<PackedLoc>::alloc_buffer(cfg.target->hst(), cfg.index_chunks),
+		return { ref_seed_arrays ? new char[sizeof(SeedArray<PackedLoc>::Entry) * ref_seed_arrays->max_chunk_size(cfg.index_chunks)]
+			: SeedArray<PackedLoc>::alloc_buffer(cfg.target->hst(), cfg.index_chunks),
 		config.target_indexed ? nullptr : SeedArray<PackedLoc>::alloc_buffer(cfg.query->hst(), cfg.index_chunks) };
 }
 
+// Returns the smallest number of index chunks for which the seed arrays of the current blocks fit into the memory
+// left over by the measured footprint of the process.
+static unsigned plan_index_chunks(const Config& cfg, const SeedArrayIndex* ref_seed_arrays) {
+	const int64_t available = Util::String::interpret_number(config.memory_limit.get(DEFAULT_MEMORY_LIMIT)) - (int64_t)getCurrentRSS();
+	const size_t entry_size = Search::keep_target_id(cfg) ? sizeof(SeedArray<PackedLocId>::Entry) : sizeof(SeedArray<PackedLoc>::Entry);
+	unsigned chunks = 1;
+	for (; chunks < (unsigned)Const::seedp; chunks *= 2) {
+		const size_t ref = ref_seed_arrays ? ref_seed_arrays->max_chunk_size(chunks) : cfg.target->hst().max_chunk_size(chunks),
+			query = config.target_indexed ? 0 : cfg.query->hst().max_chunk_size(chunks);
+		if ((int64_t)((ref + query) * entry_size) <= available)
+			break;
+	}
+	return std::min(chunks, (unsigned)Const::seedp);
+}
+
 static void run_ref_chunk(SequenceFile &db_file,
 	const unsigned query_iteration,
 	Consumer &master_out,
@@ -130,7 +152,24 @@ static void run_ref_chunk(SequenceFile &db_file,
 		cfg.target->unmasked_seqs().convert_all_to_std_alph(config.threads_);
 	}
 
-	if (cfg.target_masking != MaskingAlgo::NONE && !cfg.lazy_masking) {
+	unique_ptr<SeedArrayIndex> ref_seed_arrays;
+	if (config.seed_arrays && !config.swipe_all && !cfg.iterated() && !query_seeds_bitset && !query_seeds_hashed && !config.target_indexed
+		&& !keep_target_id(cfg) && !cfg.db_filter && cfg.seed_encoding == SeedEncoding::SPACED_FACTOR) {
+		const std::string file_name = SeedArrayIndex::file_name(db_file.file_name(), cfg.current_ref_block);
+		if (!exists(file_name))
+			message_stream << "Warning: seed array index file " << file_name << " not found." << endl;
+		else {
+			timer.go("Loading reference seed arrays");
+			ref_seed_arrays.reset(new SeedArrayIndex(file_name));
+		}
+		if (ref_seed_arrays)
+			ref_seed_arrays->check(*cfg.target, cfg, cfg.sensitivity[query_iteration].sensitivity);
+	}
+
+	if (ref_seed_arrays && cfg.target_masking != MaskingAlgo::NONE && !cfg.lazy_masking
+		&& ref_seed_arrays->load_masking(cfg.target->seqs(), cfg.target_masking))
+		timer.finish();
+	else if (cfg.target_masking != MaskingAlgo::NONE && !cfg.lazy_masking) {
 		timer.go("Masking reference");
 		size_t n = mask_seqs(cfg.target->seqs(), Masking::get(), true, cfg.target_masking);
 		timer.finish();
@@ -163,7 +202,9 @@ static void run_ref_chunk(SequenceFile &db_file,
 
 	if (!config.swipe_all) {
 		timer.go("Building reference histograms");
-		if (query_seeds_bitset.get()) {
+		if (ref_seed_arrays)
+			;
+		else if (query_seeds_bitset.get()) {
 			EnumCfg enum_cfg{ nullptr, 0, 0, cfg.seed_encoding, nullptr, false, false, cfg.seed_complexity_cut, MaskingAlgo::NONE, cfg.minimizer_window, false, false };
 			cfg.target->hst() = SeedHistogram(*cfg.target, true, query_seeds_bitset.get(), enum_cfg);
 		}
@@ -176,9 +217,17 @@ static void run_ref_chunk(SequenceFile &db_file,
 			cfg.target->hst() = SeedHistogram(*cfg.target, false, &no_filter, enum_cfg);
 		}
 
+		const unsigned index_chunks = cfg.index_chunks;
+		if (config.auto_tune && config.lowmem_ == 0) {
+			timer.go("Planning index chunks");
+			cfg.index_chunks = plan_index_chunks(cfg, ref_seed_arrays.get());
+			timer.finish();
+			verbose_stream << "Index chunks = " << cfg.index_chunks << endl;
+		}
+
 		timer.go("Allocating buffers");
 		char* ref_buffer, * query_buffer;
-		tie(ref_buffer, query_buffer) = alloc_buffers(cfg);
+		tie(ref_buffer, query_buffer) = alloc_buffers(cfg, ref_seed_arrays.get());
 		timer.finish();
 
 		::HashedSeedSet* target_seeds = nullptr;
@@ -191,7 +240,7 @@ static void run_ref_chunk(SequenceFile &db_file,
             for (unsigned i = 0; i < shapes.count(); ++i) {
                 if(config.global_ranking_targets)
                     cfg.global_ranking_buffer.reset(new Config::RankingBuffer());
-                search_shape(i, cfg.current_query_block, query_iteration, query_buffer, ref_buffer, cfg, target_seeds); //index_targets(0,cfg,ref_buffer,target_seeds);
+                search_shape(i, cfg.current_query_block, query_iteration, query_buffer, ref_buffer, cfg, target_seeds, ref_seed_arrays.get()); //index_targets(0,cfg,ref_buffer,target_seeds);
                 if (config.global_ranking_targets)
                     Extension::GlobalRanking::update_table(cfg);
             }
@@ -210,6 +259,7 @@ static void run_ref_chunk(SequenceFile &db_file,
 		delete[] ref_buffer;
 		delete[] query_buffer;
 		delete target_seeds;
+		cfg.index_chunks = index_chunks;
 
 		timer.go("Clearing query masking");
 		FrequentSeeds::clear_masking(query_seqs);
@@ -620,6 +670,9 @@ static void master_thread(TaskTimer &total_timer, Config &options)
 		load_flags |= SequenceFile::LoadFlags::QUALITY;
 	if (config.command == ::Config::blastn)
 		load_flags |= SequenceFile::LoadFlags::DNA_PRESERVATION;
+	if (config.query_batch_latency > 0)
+		load_flags |= SequenceFile::LoadFlags::BATCH_LATENCY;
+	const bool streaming = config.query_batch_size > 0 || config.query_batch_latency > 0;
 	if (config.multiprocessing && config.mp_init) {
 		TaskTimer timer("Counting query blocks", true);
 
@@ -660,10 +713,36 @@ static void master_thread(TaskTimer &total_timer, Config &options)
 		aligned_file = unique_ptr<OutputFile>(new OutputFile(config.aligned_file));
 	timer.finish();
 
+	const bool length_sort_queries = (!Search::keep_target_id(options) && config.lin_stage1 && !config.kmer_ranking) || options.min_length_ratio > 0.0;
+	const int64_t query_block_size = config.query_batch_size > 0 ? config.query_batch_size : config.block_size();
+	bool pipeline = config.pipeline && !options.self && !config.multiprocessing && config.mp_query_chunk < 0;
+	if (pipeline && query_block_size * PIPELINE_BYTES_PER_LETTER > Util::String::interpret_number(config.memory_limit.get(DEFAULT_MEMORY_LIMIT)) * PIPELINE_MEMORY_SHARE) {
+		verbose_stream << "Query block does not fit the memory limit, disabling pipelined query loading." << endl;
+		pipeline = false;
+	}
+	// Loads, sorts and masks the next query block while the current one is being searched.
+	auto prefetch_query_block = [&options, load_flags, length_sort_queries, query_block_size]() {
+		unique_ptr<Block> query(options.query_file->load_seqs(query_block_size, nullptr, load_flags));
+		if (query->empty())
+			return query;
+		if (length_sort_queries)
+			query.reset(query->length_sorted(config.threads_));
+		if (options.query_masking != MaskingAlgo::NONE)
+			mask_seqs(query->seqs(), Masking::get(), true, options.query_masking);
+		return query;
+	};
+	std::future<unique_ptr<Block>> next_query;
+
 	for (;query_file_offset < db_file->sequence_count(); ++options.current_query_block) {
 		log_rss();
 
-		if (options.self) {
+		bool prefetched = false;
+		if (next_query.valid()) {
+			timer.go("Waiting for query prefetch");
+			options.query.reset(next_query.get().release());
+			prefetched = true;
+		}
+		else if (options.self) {
 			timer.go("Seeking in database");
 			db_file->set_seqinfo_ptr(query_file_offset);
 			timer.finish();
@@ -673,7 +752,7 @@ static void master_thread(TaskTimer &total_timer, Config &options)
 		}
 		else {
 			timer.go("Loading query sequences");
-			options.query.reset(options.query_file->load_seqs(config.block_size(), nullptr, load_flags));
+			options.query.reset(options.query_file->load_seqs(query_block_size, nullptr, load_flags));
 		}
 		timer.finish();
 
@@ -683,7 +762,7 @@ static void master_thread(TaskTimer &total_timer, Config &options)
 		if ((config.mp_query_chunk >= 0) && (options.current_query_block != config.mp_query_chunk))
 			continue;
 
-		if ((!Search::keep_target_id(options) && config.lin_stage1 && !config.kmer_ranking) || options.min_length_ratio > 0.0) {
+		if (length_sort_queries && !prefetched) {
 			timer.go("Length sorting queries");
 			options.query.reset(options.query->length_sorted(config.threads_));
 			timer.finish();
@@ -693,13 +772,18 @@ static void master_thread(TaskTimer &total_timer, Config &options)
 			options.output_format->print_header(*options.out, align_mode.mode, config.matrix.c_str(), score_matrix.gap_open(), score_matrix.gap_extend(), config.max_evalue, options.query->ids()[0],
 				unsigned(align_mode.query_translated ? options.query->source_seqs()[0].length() : options.query->seqs()[0].length()));
 
-		if (options.query_masking != MaskingAlgo::NONE) {
+		if (options.query_masking != MaskingAlgo::NONE && !prefetched) {
 			timer.go("Masking queries");
 			mask_seqs(options.query->seqs(), Masking::get(), true, options.query_masking);
 			timer.finish();
 		}
 
+		if (pipeline)
+			next_query = std::async(std::launch::async, prefetch_query_block);
+
 		run_query_chunk(*options.out, unaligned_file.get(), aligned_file.get(), options);
+		if (streaming)
+			options.out->sync();
 
 		if (file_exists("stop")) {
 			message_stream << "Encountered \'stop\' file, shutting down run" << endl;
@@ -707,6 +791,9 @@ static void master_thread(TaskTimer &total_timer, Config &options)
 		}
 	}
 
+	if (next_query.valid())
+		next_query.wait();
+
 	if (options.query_file.unique()) {
 		timer.go("Closing the input file");
 		options.query_file->close();
@@ -752,8 +839,13 @@ void run(const shared_ptr<SequenceFile>& db, const shared_ptr<SequenceFile>& que
     (align_mode.sequence_type == SequenceType::amino_acid) ? value_traits = amino_acid_traits : value_traits = nucleotide_traits;
 
 	message_stream << "Temporary directory: " << TempFile::get_temp_dir() << endl;
+	Stats::reset_matrix_cache();
 
-	if (config.sensitivity >= Sensitivity::VERY_SENSITIVE)
+	if (config.auto_tune && config.chunk_size == 0.0) {
+		const int64_t mem_limit = Util::String::interpret_number(config.memory_limit.get(DEFAULT_MEMORY_LIMIT)) - (int64_t)getCurrentRSS();
+		config.chunk_size = block_size(std::max(mem_limit, (int64_t)0), config.sensitivity, config.lin_stage1).first;
+	}
+	else if (config.sensitivity >= Sensitivity::VERY_SENSITIVE)
 		::Config::set_option(config.chunk_size, 0.4);
 	else
 		::Config::set_option(config.chunk_size, 2.0);
@@ -797,6 +889,14 @@ void run(const shared_ptr<SequenceFile>& db, const shared_ptr<SequenceFile>& que
 	}
 	if (config.multiprocessing && cfg.db->type() == SequenceFile::Type::FASTA)
 		throw std::runtime_error("Multiprocessing mode is not compatible with FASTA databases.");
+	if (config.seed_arrays && cfg.db->type() == SequenceFile::Type::DMND && exists(SeedArrayIndex::file_name(cfg.db->file_name(), 0))) {
+		const double b = SeedArrayIndex::block_size(SeedArrayIndex::file_name(cfg.db->file_name(), 0));
+		if (b != config.chunk_size) {
+			timer.finish();
+			message_stream << "Using the block size of the seed array index." << endl;
+		}
+		config.chunk_size = b;
+	}
 	cfg.db_seqs = cfg.db->sequence_count();
 	cfg.db_letters = cfg.db->letters();
 	cfg.ref_blocks = cfg.db->total_blocks();
@@ -155,8 +155,49 @@ struct Byte_finger_print_48
 
 #endif
 
+// Fingerprint of the same 48 letter window reduced to a 16 letter alphabet and stored as 4 bit
+// planes. The match count is 48 minus the number of positions where any plane differs.
+struct Reduced_finger_print_48
+{
+	Reduced_finger_print_48(const Letter* q)
+	{
+		alignas(16) Letter r[48];
+		for (int i = 0; i < 48; ++i)
+			r[i] = REDUCTION[q[i - 16] & 31];
+#ifdef __SSE2__
+		const __m128i r1 = _mm_load_si128((__m128i const*)r), r2 = _mm_load_si128((__m128i const*)(r + 16)), r3 = _mm_load_si128((__m128i const*)(r + 32));
+		p[0] = plane(_mm_slli_epi16(r1, 7), _mm_slli_epi16(r2, 7), _mm_slli_epi16(r3, 7));
+		p[1] = plane(_mm_slli_epi16(r1, 6), _mm_slli_epi16(r2, 6), _mm_slli_epi16(r3, 6));
+		p[2] = plane(_mm_slli_epi16(r1, 5), _mm_slli_epi16(r2, 5), _mm_slli_epi16(r3, 5));
+		p[3] = plane(_mm_slli_epi16(r1, 4), _mm_slli_epi16(r2, 4), _mm_slli_epi16(r3, 4));
+#else
+		for (int b = 0; b < 4; ++b) {
+			p[b] = 0;
+			for (int i = 0; i < 48; ++i)
+				p[b] |= uint64_t((r[i] >> b) & 1) << i;
+		}
+#endif
+	}
+#ifdef __SSE2__
+	static uint64_t plane(__m128i x, __m128i y, __m128i z)
+	{
+		return (uint64_t)_mm_movemask_epi8(x) | (uint64_t)_mm_movemask_epi8(y) << 16 | (uint64_t)_mm_movemask_epi8(z) << 32;
+	}
+#endif
+	unsigned match(const Reduced_finger_print_48& rhs) const
+	{
+		return 48 - popcount64((p[0] ^ rhs.p[0]) | (p[1] ^ rhs.p[1]) | (p[2] ^ rhs.p[2]) | (p[3] ^ rhs.p[3]));
+	}
+	uint64_t p[4];
+	// Murphy 10 letter alphabet, the remaining letters are kept distinct.
+	static constexpr Letter REDUCTION[32] = { 0, 1, 2, 2, 3, 2, 2, 4, 5, 6, 6, 1, 6, 7, 8, 9, 9, 7, 7, 6,
+		10, 11, 12, 13, 14, 15, 15, 15, 15, 15, 15, 15 };
+};
+
 #ifdef __AVX2__
 typedef Byte_finger_print_48 FingerPrint;
 #else
 typedef Byte_finger_print_48 FingerPrint;
 #endif
+
+typedef Reduced_finger_print_48 ReducedFingerPrint;
@@ -58,6 +58,7 @@ struct SensitivityTraits {
 };
 
 struct HashedSeedSet;
+struct SeedArrayIndex;
 
 namespace Search {
 
@@ -72,7 +73,7 @@ extern const std::map<Sensitivity, std::vector<std::string>> shape_codes[2];
 extern const std::map<Sensitivity, std::vector<Sensitivity>> iterated_sens;
 extern const std::map<Sensitivity, std::vector<Sensitivity>> cluster_sens;
 
-void search_shape(unsigned sid, int query_block, unsigned query_iteration, char* query_buffer, char* ref_buffer, Config& cfg, const HashedSeedSet* target_seeds);
+void search_shape(unsigned sid, int query_block, unsigned query_iteration, char* query_buffer, char* ref_buffer, Config& cfg, const HashedSeedSet* target_seeds, const SeedArrayIndex* ref_seed_arrays);
 bool use_single_indexed(double coverage, size_t query_letters, size_t ref_letters);
 void setup_search(Sensitivity sens, Search::Config& cfg);
 MaskingAlgo soft_masking_algo(const SensitivityTraits& traits);
@@ -110,11 +111,15 @@ struct WorkSet {
 	Writer<Hit>* out;
 #ifndef __APPLE__
 	std::vector<FingerPrint, Util::Memory::AlignmentAllocator<FingerPrint, 16>> vq, vs;
+	std::vector<ReducedFingerPrint> rq, rs;
 #endif
 	FlatArray<uint32_t> hits;
 	KmerRanking* kmer_ranking;
 };
 
+// Returns the mask of the targets (n <= 16) whose stage 1 fingerprints have at least hamming_filter_id identities
+// with the fingerprint of the query.
+uint32_t match_fingerprints(const Letter* query, const Letter* const* targets, uint32_t n, unsigned hamming_filter_id);
 void run_stage1(JoinIterator<PackedLoc>& it, Search::WorkSet* work_set, const Search::Config* cfg);
 void run_stage1(JoinIterator<PackedLocId>& it, Search::WorkSet* work_set, const Search::Config* cfg);
 
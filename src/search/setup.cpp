@@ -320,6 +320,7 @@ void setup_search(Sensitivity sens, Search::Config& cfg)
 	config.sensitivity = sens;
 	::Config::set_option(cfg.freq_sd, config.freq_sd_, 0.0, traits.freq_sd);
 	::Config::set_option(cfg.hamming_filter_id, config.min_identities_, 0u, max(traits.min_identities, hamming_id_cutoff(config.approx_min_id.get(0.0))));
+	::Config::set_option(cfg.reduced_fp_id, config.reduced_fp_id, 0u, cfg.hamming_filter_id);
 	::Config::set_option(cfg.ungapped_evalue, config.ungapped_evalue_, -1.0, traits.ungapped_evalue);
 	::Config::set_option(cfg.ungapped_evalue_short, config.ungapped_evalue_short_, -1.0, traits.ungapped_evalue_short);
 	::Config::set_option(cfg.gapped_filter_evalue, config.gapped_filter_evalue_, -1.0, traits.gapped_filter_evalue);
@@ -51,8 +51,10 @@ static void seed_join_worker(
 	atomic<unsigned> *seedp,
 	const SeedPartitionRange *seedp_range,
 	DoubleArray<SeedLoc> *query_seed_hits,
-	DoubleArray<SeedLoc> *ref_seeds_hits)
+	DoubleArray<SeedLoc> *ref_seeds_hits,
+	size_t thread_id)
 {
+	bind_thread(thread_id, config.threads_);
 	int p;
 	const int bits = query_seeds->key_bits;
 	if (bits != ref_seeds->key_bits)
@@ -70,6 +72,7 @@ static void seed_join_worker(
 template<typename SeedLoc>
 static void search_worker(atomic<unsigned> *seedp, const SeedPartitionRange *seedp_range, unsigned shape, size_t thread_id, DoubleArray<SeedLoc> *query_seed_hits, DoubleArray<SeedLoc> *ref_seed_hits, const Search::Context *context, const Search::Config* cfg)
 {
+	bind_thread(thread_id, config.threads_);
 	unique_ptr<Writer<Hit>> writer;
 	if (config.global_ranking_targets)
 		writer.reset(new AsyncWriter<Hit, Search::Config::RankingBuffer::EXPONENT>(*cfg->global_ranking_buffer));
@@ -78,7 +81,7 @@ static void search_worker(atomic<unsigned> *seedp, const SeedPartitionRange *see
 #ifdef __APPLE__
 	unique_ptr<Search::WorkSet> work_set(new Search::WorkSet{ *context, *cfg, shape, {}, writer.get(), {}, context->kmer_ranking });
 #else
-	unique_ptr<Search::WorkSet> work_set(new Search::WorkSet{ *context, *cfg, shape, {}, writer.get(), {}, {}, {}, context->kmer_ranking });
+	unique_ptr<Search::WorkSet> work_set(new Search::WorkSet{ *context, *cfg, shape, {}, writer.get(), {}, {}, {}, {}, {}, context->kmer_ranking });
 #endif
 	int p;
 	while ((p = (*seedp)++) < seedp_range->end()) {
@@ -89,7 +92,7 @@ static void search_worker(atomic<unsigned> *seedp, const SeedPartitionRange *see
 }
 
 template<typename SeedLoc>
-void search_shape(unsigned sid, int query_block, unsigned query_iteration, char *query_buffer, char *ref_buffer, Search::Config& cfg, const HashedSeedSet* target_seeds)
+void search_shape(unsigned sid, int query_block, unsigned query_iteration, char *query_buffer, char *ref_buffer, Search::Config& cfg, const HashedSeedSet* target_seeds, const SeedArrayIndex* ref_seed_arrays)
 {
 	using SA = SeedArray<SeedLoc>;
 	Partition<unsigned> p(Const::seedp, cfg.index_chunks);
@@ -110,12 +113,14 @@ void search_shape(unsigned sid, int query_block, unsigned query_iteration, char
 		const SeedPartitionRange range(p.begin(chunk), p.end(chunk));
 		current_range = range;
 
-		TaskTimer timer("Building reference seed array", true);
+		TaskTimer timer(ref_seed_arrays ? "Loading reference seed array" : "Building reference seed array", true);
 		SA *ref_idx;
 		const EnumCfg enum_ref{ &ref_hst.partition(), sid, sid + 1, cfg.seed_encoding, nullptr, false, false, cfg.seed_complexity_cut,
 			query_seeds_bitset.get() || (bool)query_seeds_hashed ? MaskingAlgo::NONE : cfg.soft_masking,
 			cfg.minimizer_window, false, false };
-		if (query_seeds_bitset.get())
+		if (ref_seed_arrays)
+			ref_idx = new SA(*ref_seed_arrays, sid, range, ref_buffer);
+		else if (query_seeds_bitset.get())
 			ref_idx = new SA(*cfg.target, ref_hst.get(sid), range, ref_buffer, query_seeds_bitset.get(), enum_ref);
 		else if (query_seeds_hashed.get())
 			ref_idx = new SA(*cfg.target, ref_hst.get(sid), range, ref_buffer, query_seeds_hashed.get(), enum_ref);
@@ -147,7 +152,7 @@ void search_shape(unsigned sid, int query_block, unsigned query_iteration, char
 		atomic<unsigned> seedp(range.begin());
 		vector<std::thread> threads;
 		for (int i = 0; i < config.threads_; ++i)
-			threads.emplace_back(seed_join_worker<SeedLoc>, query_idx, ref_idx, &seedp, &range, query_seed_hits, ref_seed_hits);
+			threads.emplace_back(seed_join_worker<SeedLoc>, query_idx, ref_idx, &seedp, &range, query_seed_hits, ref_seed_hits, i);
 		for (auto &t : threads)
 			t.join();
 		timer.finish();
@@ -196,11 +201,11 @@ void search_shape(unsigned sid, int query_block, unsigned query_iteration, char
 	}
 }
 
-void search_shape(unsigned sid, int query_block, unsigned query_iteration, char* query_buffer, char* ref_buffer, Search::Config& cfg, const HashedSeedSet* target_seeds) {
+void search_shape(unsigned sid, int query_block, unsigned query_iteration, char* query_buffer, char* ref_buffer, Search::Config& cfg, const HashedSeedSet* target_seeds, const SeedArrayIndex* ref_seed_arrays) {
 	if (keep_target_id(cfg))
-		search_shape<PackedLocId>(sid, query_block, query_iteration, query_buffer, ref_buffer, cfg, target_seeds);
+		search_shape<PackedLocId>(sid, query_block, query_iteration, query_buffer, ref_buffer, cfg, target_seeds, ref_seed_arrays);
 	else
-		search_shape<PackedLoc>(sid, query_block, query_iteration, query_buffer, ref_buffer, cfg, target_seeds);
+		search_shape<PackedLoc>(sid, query_block, query_iteration, query_buffer, ref_buffer, cfg, target_seeds, ref_seed_arrays);
 }
 
 }
\ No newline at end of file
@@ -27,9 +27,10 @@ namespace Search { namespace DISPATCH_ARCH {
 	
 using Container = vector<FingerPrint, Util::Memory::AlignmentAllocator<FingerPrint, 16>>;
 
-static void all_vs_all(const FingerPrint* a, uint32_t na, const FingerPrint* b, uint32_t nb, FlatArray<uint32_t>& out, unsigned hamming_filter_id) {
+template<typename Fp>
+static void all_vs_all(const Fp* a, uint32_t na, const Fp* b, uint32_t nb, FlatArray<uint32_t>& out, unsigned hamming_filter_id) {
 	for (uint32_t i = 0; i < na; ++i) {
-		const FingerPrint e = a[i];
+		const Fp e = a[i];
 		out.next();
 		for (uint32_t j = 0; j < nb; ++j)
 			if (e.match(b[j]) >= hamming_filter_id)
@@ -37,9 +38,10 @@ static void all_vs_all(const FingerPrint* a, uint32_t na, const FingerPrint* b,
 	}
 }
 
-static void all_vs_all_self(const FingerPrint* a, uint32_t na, FlatArray<uint32_t>& out, unsigned hamming_filter_id) {
+template<typename Fp>
+static void all_vs_all_self(const Fp* a, uint32_t na, FlatArray<uint32_t>& out, unsigned hamming_filter_id) {
 	for (uint32_t i = 0; i < na; ++i) {
-		const FingerPrint e = a[i];
+		const Fp e = a[i];
 		out.next();
 		for (uint32_t j = i + 1; j < na; ++j)
 			if (e.match(a[j]) >= hamming_filter_id)
@@ -47,6 +49,66 @@ static void all_vs_all_self(const FingerPrint* a, uint32_t na, FlatArray<uint32_
 	}
 }
 
+#if ARCH_ID == 3
+
+constexpr __mmask64 FP_MASK = 0xffffffffffffllu;
+
+// Bit counts of the 64 bit lanes. Without VPOPCNTDQ the bytes are counted by nibble lookups and summed by SAD,
+// which only needs AVX-512BW.
+static inline __m512i popcount_epi64(const __m512i v) {
+#ifdef __AVX512VPOPCNTDQ__
+	return _mm512_popcnt_epi64(v);
+#else
+	const __m512i lut = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4)),
+		low = _mm512_set1_epi8(0x0f),
+		c = _mm512_add_epi8(_mm512_shuffle_epi8(lut, _mm512_and_si512(v, low)), _mm512_shuffle_epi8(lut, _mm512_and_si512(_mm512_srli_epi16(v, 4), low)));
+	return _mm512_sad_epu8(c, _mm512_setzero_si512());
+#endif
+}
+
+// Compares the fingerprint q against n <= 16 targets. The byte match masks of the targets are collected into two
+// vectors of 64 bit lanes, so that the identities of all 16 targets are counted and compared to the threshold by
+// one group of vector instructions. Returns the mask of the targets that pass.
+static inline uint32_t match_block(const __m512i q, const FingerPrint* b, uint32_t n, unsigned hamming_filter_id) {
+	__m512i lo = _mm512_setzero_si512(), hi = _mm512_setzero_si512();
+	const uint32_t n_lo = std::min(n, 8u);
+	for (uint32_t k = 0; k < n_lo; ++k)
+		lo = _mm512_mask_set1_epi64(lo, __mmask8(1u << k), (long long)_mm512_mask_cmpeq_epi8_mask(FP_MASK, q, _mm512_maskz_loadu_epi8(FP_MASK, b + k)));
+	for (uint32_t k = 8; k < n; ++k)
+		hi = _mm512_mask_set1_epi64(hi, __mmask8(1u << (k - 8)), (long long)_mm512_mask_cmpeq_epi8_mask(FP_MASK, q, _mm512_maskz_loadu_epi8(FP_MASK, b + k)));
+	const __m512i t = _mm512_set1_epi64(hamming_filter_id);
+	const uint32_t hits = (uint32_t)_mm512_cmpge_epu64_mask(popcount_epi64(lo), t) | (uint32_t)_mm512_cmpge_epu64_mask(popcount_epi64(hi), t) << 8;
+	return n == 16 ? hits : hits & ((1u << n) - 1);
+}
+
+static inline void match_row(const FingerPrint& e, const FingerPrint* b, uint32_t begin, uint32_t end, FlatArray<uint32_t>& out, unsigned hamming_filter_id) {
+	static_assert(sizeof(FingerPrint) == 48, "Unexpected fingerprint size.");
+	const __m512i q = _mm512_maskz_loadu_epi8(FP_MASK, &e);
+	for (uint32_t j = begin; j < end; j += 16) {
+		uint32_t hits = match_block(q, b + j, std::min(end - j, 16u), hamming_filter_id);
+		while (hits) {
+			out.push_back(j + ctz(hits));
+			hits &= hits - 1;
+		}
+	}
+}
+
+static void all_vs_all(const FingerPrint* a, uint32_t na, const FingerPrint* b, uint32_t nb, FlatArray<uint32_t>& out, unsigned hamming_filter_id) {
+	for (uint32_t i = 0; i < na; ++i) {
+		out.next();
+		match_row(a[i], b, 0, nb, out, hamming_filter_id);
+	}
+}
+
+static void all_vs_all_self(const FingerPrint* a, uint32_t na, FlatArray<uint32_t>& out, unsigned hamming_filter_id) {
+	for (uint32_t i = 0; i < na; ++i) {
+		out.next();
+		match_row(a[i], a, i + 1, na, out, hamming_filter_id);
+	}
+}
+
+#endif
+
 static void all_vs_all_mutual_cov(const PackedLocId* q, const PackedLocId* s, const FingerPrint* a, uint32_t na, const FingerPrint* b, uint32_t nb, FlatArray<uint32_t>& out, unsigned hamming_filter_id, WorkSet& work_set) {
 	uint32_t j0 = 0, j1 = 0;
 	const double mlr = work_set.cfg.min_length_ratio;
@@ -94,8 +156,8 @@ static void all_vs_all_self_mutual_cov(const PackedLocId* q, const FingerPrint*
 	}
 }
 
-template<typename SeedLoc>
-static void load_fps(const SeedLoc* p, size_t n, Container& v, const SequenceSet& seqs)
+template<typename SeedLoc, typename C>
+static void load_fps(const SeedLoc* p, size_t n, C& v, const SequenceSet& seqs)
 {
 	v.clear();
 	v.reserve(n);
@@ -105,14 +167,37 @@ static void load_fps(const SeedLoc* p, size_t n, Container& v, const SequenceSet
 	}
 }
 
-template<typename SeedLoc>
-static void FLATTEN stage1(const SeedLoc* q, int32_t nq, const SeedLoc* s, int32_t ns, WorkSet& work_set)
-{
+template<typename Fp>
+struct FingerPrints {
+	using Container = DISPATCH_ARCH::Container;
 #ifdef __APPLE__
-	thread_local Container vq, vs;
+	static Container& query(WorkSet&) { thread_local Container v; return v; }
+	static Container& target(WorkSet&) { thread_local Container v; return v; }
 #else
-	Container& vq = work_set.vq, &vs = work_set.vs;
+	static Container& query(WorkSet& work_set) { return work_set.vq; }
+	static Container& target(WorkSet& work_set) { return work_set.vs; }
+#endif
+	static unsigned filter_id(const Search::Config& cfg) { return cfg.hamming_filter_id; }
+};
+
+template<>
+struct FingerPrints<ReducedFingerPrint> {
+	using Container = vector<ReducedFingerPrint>;
+#ifdef __APPLE__
+	static Container& query(WorkSet&) { thread_local Container v; return v; }
+	static Container& target(WorkSet&) { thread_local Container v; return v; }
+#else
+	static Container& query(WorkSet& work_set) { return work_set.rq; }
+	static Container& target(WorkSet& work_set) { return work_set.rs; }
 #endif
+	static unsigned filter_id(const Search::Config& cfg) { return cfg.reduced_fp_id; }
+};
+
+template<typename SeedLoc, typename Fp>
+static void FLATTEN stage1(const SeedLoc* q, int32_t nq, const SeedLoc* s, int32_t ns, WorkSet& work_set)
+{
+	auto& vq = FingerPrints<Fp>::query(work_set), &vs = FingerPrints<Fp>::target(work_set);
+	const unsigned filter_id = FingerPrints<Fp>::filter_id(work_set.cfg);
 	
 	const int32_t tile_size = config.tile_size;
 	load_fps(s, ns, vs, work_set.cfg.target->seqs());
@@ -122,7 +207,7 @@ static void FLATTEN stage1(const SeedLoc* q, int32_t nq, const SeedLoc* s, int32
 	for (int32_t i = 0; i < qs; i += tile_size) {
 		for (int32_t j = 0; j < ss; j += tile_size) {
 			work_set.hits.clear();
-			all_vs_all(vq.data() + i, std::min(tile_size, qs - i), vs.data() + j, std::min(tile_size, ss - j), work_set.hits, work_set.cfg.hamming_filter_id);
+			all_vs_all(vq.data() + i, std::min(tile_size, qs - i), vs.data() + j, std::min(tile_size, ss - j), work_set.hits, filter_id);
 			search_tile(work_set.hits, i, j, q, s, work_set);
 		}
 	}
@@ -193,14 +278,11 @@ static void FLATTEN stage1_target_lin(const SeedLoc* q, int32_t nq, const SeedLo
 	}
 }
 
-template<typename SeedLoc>
+template<typename SeedLoc, typename Fp>
 static void FLATTEN stage1_self(const SeedLoc* q, int32_t nq, const SeedLoc* s, int32_t ns, WorkSet& work_set)
 {
-#ifdef __APPLE__
-	thread_local Container vs;
-#else
-	Container& vs = work_set.vs;
-#endif
+	auto& vs = FingerPrints<Fp>::target(work_set);
+	const unsigned filter_id = FingerPrints<Fp>::filter_id(work_set.cfg);
 
 	const int32_t tile_size = config.tile_size;
 	load_fps(s, ns, vs, work_set.cfg.target->seqs());
@@ -209,11 +291,11 @@ static void FLATTEN stage1_self(const SeedLoc* q, int32_t nq, const SeedLoc* s,
 	const int32_t ss = (int32_t)vs.size();
 	for (int32_t i = 0; i < ss; i += tile_size) {
 		work_set.hits.clear();
-		all_vs_all_self(vs.data() + i, std::min(tile_size, ss - i), work_set.hits, work_set.cfg.hamming_filter_id);
+		all_vs_all_self(vs.data() + i, std::min(tile_size, ss - i), work_set.hits, filter_id);
 		search_tile(work_set.hits, i, i, s, s, work_set);
 		for (int32_t j = i + tile_size; j < ss; j += tile_size) {
 			work_set.hits.clear();
-			all_vs_all(vs.data() + i, std::min(tile_size, ss - i), vs.data() + j, std::min(tile_size, ss - j), work_set.hits, work_set.cfg.hamming_filter_id);
+			all_vs_all(vs.data() + i, std::min(tile_size, ss - i), vs.data() + j, std::min(tile_size, ss - j), work_set.hits, filter_id);
 			search_tile(work_set.hits, i, j, s, s, work_set);
 		}
 	}
@@ -349,15 +431,17 @@ static Stage1FnPackedLocId* stage1_dispatch(const Search::Config* cfg, PackedLoc
 		return config.self && cfg->current_ref_block == 0 ? stage1_self_mutual_cov : stage1_mutual_cov;
 	}
 	if (config.self && cfg->current_ref_block == 0) {
-		return stage1_self;
+		return cfg->reduced_fp ? stage1_self<PackedLocId, ReducedFingerPrint> : stage1_self<PackedLocId, FingerPrint>;
 	}
-	return stage1;
+	return cfg->reduced_fp ? stage1<PackedLocId, ReducedFingerPrint> : stage1<PackedLocId, FingerPrint>;
 }
 
 static Stage1FnPackedLoc* stage1_dispatch(const Search::Config* cfg, PackedLoc) {
 	return config.lin_stage1 ? stage1_query_lin
 		: (cfg->lin_stage1_target ? stage1_target_lin<PackedLoc>
-			: (config.self && cfg->current_ref_block == 0 ? stage1_self<PackedLoc> : stage1<PackedLoc>));
+			: (config.self && cfg->current_ref_block == 0
+				? (cfg->reduced_fp ? stage1_self<PackedLoc, ReducedFingerPrint> : stage1_self<PackedLoc, FingerPrint>)
+				: (cfg->reduced_fp ? stage1<PackedLoc, ReducedFingerPrint> : stage1<PackedLoc, FingerPrint>)));
 }
 
 void run_stage1(JoinIterator<PackedLoc>& it, Search::WorkSet* work_set, const Search::Config* cfg) {
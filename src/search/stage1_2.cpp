@@ -21,8 +21,26 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "stage1.h"
 #include "../util/simd/dispatch.h"
 
-namespace Search {
+namespace Search { namespace DISPATCH_ARCH {
+
+uint32_t match_fingerprints(const Letter* query, const Letter* const* targets, uint32_t n, unsigned hamming_filter_id) {
+	const FingerPrint e(query);
+	Container fp;
+	for (uint32_t k = 0; k < n; ++k)
+		fp.emplace_back(targets[k]);
+#if ARCH_ID == 3
+	return match_block(_mm512_maskz_loadu_epi8(FP_MASK, &e), fp.data(), n, hamming_filter_id);
+#else
+	uint32_t hits = 0;
+	for (uint32_t k = 0; k < n; ++k)
+		hits |= uint32_t(e.match(fp[k]) >= hamming_filter_id) << k;
+	return hits;
+#endif
+}
+
+}
 	
+DISPATCH_4(uint32_t, match_fingerprints, const Letter*, query, const Letter* const*, targets, uint32_t, n, unsigned, hamming_filter_id)
 DISPATCH_3V(run_stage1, JoinIterator<PackedLoc>&, it, Search::WorkSet*, work_set, const Search::Config*, cfg)
 DISPATCH_3V(run_stage1, JoinIterator<PackedLocId>&, it, Search::WorkSet*, work_set, const Search::Config*, cfg)
 
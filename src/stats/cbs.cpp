@@ -18,15 +18,141 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ****/
 
+#include <list>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <math.h>
 #include "cbs.h"
 #include "../basic/config.h"
 #include "score_matrix.h"
 #include "../masking/masking.h"
 
 using std::vector;
+using std::string;
 
 namespace Stats {
 
+std::atomic<int64_t> matrix_cache_hits(0), matrix_cache_misses(0);
+
+// Sharded LRU cache of adjusted matrices. With a positive tolerance, the compositions and lengths are quantised and the
+// matrices are computed from the quantised values, so that a cached matrix does not depend on which target was seen
+// first.
+struct MatrixCache {
+
+    enum { SHARDS = 64 };
+
+    MatrixCache(size_t capacity, double tolerance):
+        shard_capacity(std::max(capacity / SHARDS, (size_t)1)),
+        tolerance(tolerance)
+    {}
+
+    void quantise_query(Composition& comp, int& len) const {
+        if (tolerance > 0.0) {
+            quantise(comp);
+            len = quantise(len);
+        }
+    }
+
+    void quantise_target(Composition& comp, int& len, int& true_aa) const {
+        if (tolerance > 0.0) {
+            quantise(comp);
+            len = quantise(len);
+            true_aa = std::min(quantise(true_aa), len);
+        }
+    }
+
+    static string key(const Composition& query_comp, int query_len, const Composition& target_comp, int target_len, int target_true_aa) {
+        string k;
+        k.reserve(2 * TRUE_AA * sizeof(double) + 3 * sizeof(int));
+        for (double x : query_comp)
+            append(k, x);
+        for (double x : target_comp)
+            append(k, x);
+        append(k, query_len);
+        append(k, target_len);
+        append(k, target_true_aa);
+        return k;
+    }
+
+    bool get(const string& key, TargetMatrix& matrix) {
+        Shard& s = shard(key);
+        std::lock_guard<std::mutex> lock(s.mtx);
+        auto it = s.index.find(key);
+        if (it == s.index.end())
+            return false;
+        s.lru.splice(s.lru.begin(), s.lru, it->second);
+        matrix = it->second->second;
+        return true;
+    }
+
+    void put(const string& key, const TargetMatrix& matrix) {
+        Shard& s = shard(key);
+        std::lock_guard<std::mutex> lock(s.mtx);
+        if (s.index.find(key) != s.index.end())
+            return;
+        s.lru.emplace_front(key, matrix);
+        s.index[key] = s.lru.begin();
+        if (s.lru.size() > shard_capacity) {
+            s.index.erase(s.lru.back().first);
+            s.lru.pop_back();
+        }
+    }
+
+private:
+
+    using List = std::list<std::pair<string, TargetMatrix>>;
+
+    struct Shard {
+        std::mutex mtx;
+        List lru;
+        std::unordered_map<string, List::iterator> index;
+    };
+
+    // Rounds the frequencies to multiples of the tolerance and normalizes them again.
+    void quantise(Composition& c) const {
+        double sum = 0.0;
+        for (double& x : c)
+            sum += (x = (double)lround(x / tolerance) * tolerance);
+        if (sum > 0.0)
+            for (double& x : c)
+                x /= sum;
+    }
+
+    // Rounds a length to a log scale with a relative bucket width equal to the tolerance.
+    int quantise(int len) const {
+        if (len <= 0)
+            return len;
+        const double w = log1p(tolerance);
+        return std::max((int)lround(exp((double)lround(log((double)len) / w) * w)), 1);
+    }
+
+    template<typename T>
+    static void append(string& k, T x) {
+        k.append((const char*)&x, sizeof(T));
+    }
+
+    Shard& shard(const string& key) {
+        return shards[std::hash<string>()(key) % SHARDS];
+    }
+
+    const size_t shard_capacity;
+    const double tolerance;
+    Shard shards[SHARDS];
+
+};
+
+static std::unique_ptr<MatrixCache> matrix_cache_;
+
+static MatrixCache* matrix_cache() {
+    return matrix_cache_.get();
+}
+
+void reset_matrix_cache() {
+    matrix_cache_.reset(config.cbs_cache > 0 ? new MatrixCache(config.cbs_cache, config.cbs_cache_tolerance) : nullptr);
+}
+
 CBS comp_based_stats(0, -1.0, -1.0, -1.0);
 
 CBS::CBS(unsigned code, double query_match_distance_threshold, double length_ratio_threshold, double angle):
@@ -100,26 +226,55 @@ TargetMatrix::TargetMatrix(const Composition& query_comp, int query_len, const S
 
     //auto c = composition(target);
     auto c = composition(Sequence(target_seq.data(), target_seq.size()));
-    EMatrixAdjustRule rule = eUserSpecifiedRelEntropy;
-    if (CBS::conditioned(config.comp_based_stats)) {
-        rule = s_TestToApplyREAdjustmentConditional(query_len, (int)target.length(), query_comp.data(), c.data(), score_matrix.background_freqs());
-        if (rule == eCompoScaleOldMatrix && config.comp_based_stats != CBS::COMP_BASED_STATS_AND_MATRIX_ADJUST)
+    int target_len = (int)target.length(), target_true_aa = count_true_aa(target);
+    MatrixCache* cache = matrix_cache();
+    if (cache) {
+        Composition qc = query_comp;
+        int ql = query_len;
+        cache->quantise_query(qc, ql);
+        cache->quantise_target(c, target_len, target_true_aa);
+        const string key = MatrixCache::key(qc, ql, c, target_len, target_true_aa);
+        if (cache->get(key, *this)) {
+            ++matrix_cache_hits;
             return;
+        }
+        ++matrix_cache_misses;
+        adjust(qc, ql, target_len, target_true_aa, c);
+        cache->put(key, *this);
     }
+    else
+        adjust(query_comp, query_len, target_len, target_true_aa, c);
+}
 
-    scores.resize(32 * AMINO_ACID_COUNT);
-    scores32.resize(32 * AMINO_ACID_COUNT);
-    score_min = INT_MAX;
-    score_max = INT_MIN;
-    vector<int> s;
+// Returns the rule for adjusting the matrix of a target, eDontAdjustMatrix if the standard matrix is used.
+static EMatrixAdjustRule adjust_rule(const Composition& query_comp, int query_len, int target_len, const Composition& c)
+{
+    if (!CBS::conditioned(config.comp_based_stats))
+        return eUserSpecifiedRelEntropy;
+    const EMatrixAdjustRule rule = s_TestToApplyREAdjustmentConditional(query_len, target_len, query_comp.data(), c.data(), score_matrix.background_freqs());
+    return rule == eCompoScaleOldMatrix && config.comp_based_stats != CBS::COMP_BASED_STATS_AND_MATRIX_ADJUST ? eDontAdjustMatrix : rule;
+}
+
+void TargetMatrix::adjust(const Composition& query_comp, int query_len, int target_len, int target_true_aa, const Composition& c)
+{
+    const EMatrixAdjustRule rule = adjust_rule(query_comp, query_len, target_len, c);
+    if (rule == eDontAdjustMatrix)
+        return;
     
     if (config.comp_based_stats == CBS::COMP_BASED_STATS || rule == eCompoScaleOldMatrix)
-        s = CompositionBasedStats(score_matrix.matrix32_scaled_pointers().data(), query_comp, c, score_matrix.ungapped_lambda(), score_matrix.freq_ratios());
+        set_scores(CompositionBasedStats(score_matrix.matrix32_scaled_pointers().data(), query_comp, c, score_matrix.ungapped_lambda(), score_matrix.freq_ratios()));
     else if (config.comp_based_stats == CBS::HAUSER_GLOBAL)
-        s = hauser_global(query_comp, c);
+        set_scores(hauser_global(query_comp, c));
     else
-        s = CompositionMatrixAdjust(query_len, count_true_aa(target), query_comp.data(), c.data(), config.cbs_matrix_scale, score_matrix.ideal_lambda(), score_matrix.joint_probs(), score_matrix.background_freqs());
-    
+        set_scores(CompositionMatrixAdjust(query_len, target_true_aa, query_comp.data(), c.data(), config.cbs_matrix_scale, score_matrix.ideal_lambda(), score_matrix.joint_probs(), score_matrix.background_freqs()));
+}
+
+void TargetMatrix::set_scores(const vector<int>& s)
+{
+    scores.resize(32 * AMINO_ACID_COUNT);
+    scores32.resize(32 * AMINO_ACID_COUNT);
+    score_min = INT_MAX;
+    score_max = INT_MIN;
     for (size_t i = 0; i < AMINO_ACID_COUNT; ++i) {
         for (size_t j = 0; j < AMINO_ACID_COUNT; ++j)
             if ((i < 20 || i == MASK_LETTER) && (j < 20 || j == MASK_LETTER)) {
@@ -139,6 +294,64 @@ TargetMatrix::TargetMatrix(const Composition& query_comp, int query_len, const S
     }
 }
 
+vector<TargetMatrix> TargetMatrix::batch(const Composition& query_comp, int query_len, const vector<Sequence>& targets)
+{
+    vector<TargetMatrix> out(targets.size());
+    if (!CBS::matrix_adjust(config.comp_based_stats) || query_len == 0)
+        return out;
+    if (config.comp_based_stats == CBS::COMP_BASED_STATS || config.comp_based_stats == CBS::HAUSER_GLOBAL) {
+        for (size_t i = 0; i < targets.size(); ++i)
+            out[i] = TargetMatrix(query_comp, query_len, targets[i]);
+        return out;
+    }
+
+    MatrixCache* cache = matrix_cache();
+    Composition qc = query_comp;
+    int ql = query_len;
+    if (cache)
+        cache->quantise_query(qc, ql);
+    vector<Composition> comp(targets.size());
+    vector<string> keys(cache ? targets.size() : 0);
+    vector<size_t> pending;
+    vector<int> target_len;
+    vector<const double*> target_comp;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const Sequence& target = targets[i];
+        if (target.length() == 0)
+            continue;
+        comp[i] = composition(target);
+        int len = (int)target.length(), true_aa = count_true_aa(target);
+        if (cache) {
+            cache->quantise_target(comp[i], len, true_aa);
+            keys[i] = MatrixCache::key(qc, ql, comp[i], len, true_aa);
+            if (cache->get(keys[i], out[i])) {
+                ++matrix_cache_hits;
+                continue;
+            }
+            ++matrix_cache_misses;
+        }
+        const EMatrixAdjustRule rule = adjust_rule(qc, ql, len, comp[i]);
+        if (rule == eCompoScaleOldMatrix)
+            out[i].set_scores(CompositionBasedStats(score_matrix.matrix32_scaled_pointers().data(), qc, comp[i], score_matrix.ungapped_lambda(), score_matrix.freq_ratios()));
+        else if (rule != eDontAdjustMatrix) {
+            pending.push_back(i);
+            target_len.push_back(true_aa);
+            target_comp.push_back(comp[i].data());
+            continue;
+        }
+        if (cache)
+            cache->put(keys[i], out[i]);
+    }
+
+    const vector<vector<int>> s = CompositionMatrixAdjust(ql, target_len, qc.data(), target_comp, config.cbs_matrix_scale, score_matrix.ideal_lambda(), score_matrix.joint_probs(), score_matrix.background_freqs());
+    for (size_t i = 0; i < pending.size(); ++i) {
+        out[pending[i]].set_scores(s[i]);
+        if (cache)
+            cache->put(keys[pending[i]], out[pending[i]]);
+    }
+    return out;
+}
+
 TargetMatrix::TargetMatrix(const int16_t* query_matrix, const int16_t* target_matrix) :
     scores(32 * AMINO_ACID_COUNT),
     scores32(32 * AMINO_ACID_COUNT),
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <vector>
 #include "../basic/sequence.h"
 #include "standard_matrix.h"
@@ -31,6 +32,11 @@ using Composition = std::array<double, TRUE_AA>;
 
 Composition composition(const Sequence& s);
 
+// Hits and misses of the adjusted matrix cache (--cbs-cache).
+extern std::atomic<int64_t> matrix_cache_hits, matrix_cache_misses;
+// Discards the cached matrices and sets up the cache according to the current options, called at the start of a run.
+void reset_matrix_cache();
+
 struct TargetMatrix {
 
     TargetMatrix()
@@ -39,6 +45,10 @@ struct TargetMatrix {
     TargetMatrix(const int16_t* query_matrix, const int16_t* target_matrix);
 
     TargetMatrix(const Composition& query_comp, int query_len, const Sequence& target);
+    void adjust(const Composition& query_comp, int query_len, int target_len, int target_true_aa, const Composition& target_comp);
+    void set_scores(const std::vector<int>& s);
+    // Computes the matrices for a set of targets, batching the optimization across targets.
+    static std::vector<TargetMatrix> batch(const Composition& query_comp, int query_len, const std::vector<Sequence>& targets);
     int score_width() const;
     bool blank() const {
         return scores.empty();
@@ -201,6 +211,8 @@ struct CBS {
 };
 
 std::vector<int> CompositionMatrixAdjust(int query_len, int target_len, const double* query_comp, const double* target_comp, int scale, double ungapped_lambda, const double* joint_probs, const double* background_freqs);
+// Computes the adjusted matrices for a set of targets, solving the optimization problems of several targets at once.
+std::vector<std::vector<int>> CompositionMatrixAdjust(int query_len, const std::vector<int>& target_len, const double* query_comp, const std::vector<const double*>& target_comp, int scale, double ungapped_lambda, const double* joint_probs, const double* background_freqs);
 std::vector<int> CompositionBasedStats(const int* const* matrix_in, const Composition& queryProb, const Composition& resProb, double lambda, const FreqRatios& freq_ratios);
 std::vector<int> hauser_global(const Composition& query_comp, const Composition& target_comp);
 int Blast_OptimizeTargetFrequencies(double x[],
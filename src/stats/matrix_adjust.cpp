@@ -110,6 +110,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+#include <algorithm>
 #include "../lib/blast/nlm_linear_algebra.h"
 #include "cbs.h"
 
@@ -1117,6 +1118,273 @@ Blast_CompositionMatrixAdj(int** matrix,
             lambda);
 }
 
+/** Number of optimization problems solved in lockstep by
+ *  OptimizeTargetFrequenciesBatch. */
+static constexpr int BATCH_LANES = 8;
+
+/**
+ * Solves the optimization problem of Blast_OptimizeTargetFrequencies
+ * with a constrained relative entropy for BATCH_LANES pairs of row and
+ * column sums at once.  The per-problem arrays are stored
+ * lane-interleaved (element k of lane l at index k * BATCH_LANES + l),
+ * so that the inner loops run across the lanes.  Each lane goes through
+ * the same sequence of floating point operations as the scalar routine
+ * and is frozen once it has converged or exceeded the iteration limit,
+ * so the results match those of solving the problems one by one.
+ *
+ * @param x         the optimal target frequencies (lane-interleaved)
+ * @param status    the return status of each lane, as returned by
+ *                  Blast_OptimizeTargetFrequencies
+ * @param q         standard target frequencies, shared by all lanes
+ * @param row_sums  required row sums (lane-interleaved)
+ * @param col_sums  required column sums (lane-interleaved)
+ */
+static void
+OptimizeTargetFrequenciesBatch(double x[],
+    int status[],
+    const double q[],
+    const double row_sums[],
+    const double col_sums[],
+    double relative_entropy,
+    double tol,
+    int maxits)
+{
+    enum { L = BATCH_LANES, alphsize = COMPO_NUM_TRUE_AA, n = alphsize * alphsize, mA = 2 * alphsize - 1, m = mA + 1 };
+    vector<double> z(m * L, 0.0), resids_x(n * L), resids_z(m * L), old_scores(n * L), grads0(n * L), grads1(n * L),
+        Dinv(n * L), workspace(n * L), W(m * m * L);
+    double values0[L], values1[L], norm_x[L], norm_z[L], rnorm[L], alpha[L];
+    int its[L];
+    bool active[L], step[L];
+
+    /* Computes the Euclidean norms of the lane-interleaved vectors v
+       of length len, in the same way as Nlm_EuclideanNorm. */
+    auto norm = [](double* out, const double* v, int len) {
+        double sum[L], scale[L];
+        for (int l = 0; l < L; ++l) {
+            sum[l] = 1.0;
+            scale[l] = 0.0;
+        }
+        for (int i = 0; i < len; ++i)
+            for (int l = 0; l < L; ++l)
+                if (v[i * L + l] != 0.0) {
+                    const double absvi = fabs(v[i * L + l]);
+                    if (scale[l] < absvi) {
+                        sum[l] = 1.0 + sum[l] * (scale[l] / absvi) * (scale[l] / absvi);
+                        scale[l] = absvi;
+                    }
+                    else
+                        sum[l] += (absvi / scale[l]) * (absvi / scale[l]);
+                }
+        for (int l = 0; l < L; ++l)
+            out[l] = scale[l] * sqrt(sum[l]);
+    };
+
+    for (int i = 0; i < alphsize; ++i)
+        for (int j = 0; j < alphsize; ++j) {
+            const int k = i * alphsize + j;
+            for (int l = 0; l < L; ++l) {
+                old_scores[k * L + l] = log(q[k] / (row_sums[i * L + l] * col_sums[j * L + l]));
+                x[k * L + l] = q[k];
+            }
+        }
+    for (int l = 0; l < L; ++l) {
+        its[l] = 0;
+        active[l] = true;
+    }
+
+    for (;;) {
+        /* EvaluateReFunctions */
+        for (int l = 0; l < L; ++l)
+            values0[l] = values1[l] = 0.0;
+        for (int k = 0; k < n; ++k)
+            for (int l = 0; l < L; ++l) {
+                const int kl = k * L + l;
+                double temp = log(x[kl] / q[k]);
+                values0[l] += x[kl] * temp;
+                grads0[kl] = temp + 1;
+                temp += old_scores[kl];
+                values1[l] += x[kl] * temp;
+                grads1[kl] = temp + 1;
+            }
+
+        /* CalculateResiduals */
+        for (int k = 0; k < n; ++k)
+            for (int l = 0; l < L; ++l)
+                resids_x[k * L + l] = -grads0[k * L + l] + z[mA * L + l] * grads1[k * L + l];
+        for (int i = 0; i < alphsize; ++i)
+            for (int j = 0; j < alphsize; ++j) {
+                const int k = i * alphsize + j;
+                for (int l = 0; l < L; ++l) {
+                    resids_x[k * L + l] += 1.0 * z[j * L + l];
+                    if (i > 0)
+                        resids_x[k * L + l] += 1.0 * z[(i + alphsize - 1) * L + l];
+                }
+            }
+        norm(norm_x, resids_x.data(), n);
+
+        for (int i = 0; i < alphsize; ++i)
+            for (int l = 0; l < L; ++l)
+                resids_z[i * L + l] = col_sums[i * L + l];
+        for (int i = 1; i < alphsize; ++i)
+            for (int l = 0; l < L; ++l)
+                resids_z[(i + alphsize - 1) * L + l] = row_sums[i * L + l];
+        for (int i = 0; i < alphsize; ++i)
+            for (int j = 0; j < alphsize; ++j)
+                for (int l = 0; l < L; ++l)
+                    resids_z[j * L + l] += -1.0 * x[(i * alphsize + j) * L + l];
+        for (int i = 1; i < alphsize; ++i)
+            for (int j = 0; j < alphsize; ++j)
+                for (int l = 0; l < L; ++l)
+                    resids_z[(i + alphsize - 1) * L + l] += -1.0 * x[(i * alphsize + j) * L + l];
+        for (int l = 0; l < L; ++l)
+            resids_z[mA * L + l] = relative_entropy - values1[l];
+        norm(norm_z, resids_z.data(), m);
+        for (int l = 0; l < L; ++l)
+            rnorm[l] = sqrt(norm_x[l] * norm_x[l] + norm_z[l] * norm_z[l]);
+
+        /* Check convergence of each lane, see Blast_OptimizeTargetFrequencies */
+        bool any = false;
+        for (int l = 0; l < L; ++l) {
+            step[l] = false;
+            if (!active[l])
+                continue;
+            if (rnorm[l] > tol && ++its[l] <= maxits) {
+                step[l] = true;
+                any = true;
+                continue;
+            }
+            active[l] = false;
+            status[l] = (its[l] <= maxits && rnorm[l] <= tol && z[mA * L + l] < 1) ? 0 : 1;
+        }
+        if (!any)
+            break;
+
+        /* FactorReNewtonSystem */
+        for (int k = 0; k < n; ++k)
+            for (int l = 0; l < L; ++l)
+                Dinv[k * L + l] = x[k * L + l] / (1 - z[mA * L + l]);
+        for (int r = 0; r < m; ++r)
+            for (int c = 0; c <= r; ++c)
+                for (int l = 0; l < L; ++l)
+                    W[(r * m + c) * L + l] = 0.0;
+        for (int i = 0; i < alphsize; ++i)
+            for (int j = 0; j < alphsize; ++j)
+                for (int l = 0; l < L; ++l) {
+                    const double dd = Dinv[(i * alphsize + j) * L + l];
+                    W[(j * m + j) * L + l] += dd;
+                    if (i > 0) {
+                        W[((i + alphsize - 1) * m + j) * L + l] += dd;
+                        W[((i + alphsize - 1) * m + i + alphsize - 1) * L + l] += dd;
+                    }
+                }
+        for (int k = 0; k < n; ++k)
+            for (int l = 0; l < L; ++l) {
+                workspace[k * L + l] = Dinv[k * L + l] * grads1[k * L + l];
+                W[(mA * m + mA) * L + l] += grads1[k * L + l] * workspace[k * L + l];
+            }
+        for (int i = 0; i < alphsize; ++i)
+            for (int j = 0; j < alphsize; ++j)
+                for (int l = 0; l < L; ++l)
+                    W[(mA * m + j) * L + l] += 1.0 * workspace[(i * alphsize + j) * L + l];
+        for (int i = 1; i < alphsize; ++i)
+            for (int j = 0; j < alphsize; ++j)
+                for (int l = 0; l < L; ++l)
+                    W[(mA * m + i + alphsize - 1) * L + l] += 1.0 * workspace[(i * alphsize + j) * L + l];
+
+        /* Nlm_FactorLtriangPosDef */
+        for (int i = 0; i < m; ++i) {
+            double temp[L];
+            for (int j = 0; j < i; ++j) {
+                for (int l = 0; l < L; ++l)
+                    temp[l] = W[(i * m + j) * L + l];
+                for (int k = 0; k < j; ++k)
+                    for (int l = 0; l < L; ++l)
+                        temp[l] -= W[(i * m + k) * L + l] * W[(j * m + k) * L + l];
+                for (int l = 0; l < L; ++l)
+                    W[(i * m + j) * L + l] = temp[l] / W[(j * m + j) * L + l];
+            }
+            for (int l = 0; l < L; ++l)
+                temp[l] = W[(i * m + i) * L + l];
+            for (int k = 0; k < i; ++k)
+                for (int l = 0; l < L; ++l)
+                    temp[l] -= W[(i * m + k) * L + l] * W[(i * m + k) * L + l];
+            for (int l = 0; l < L; ++l)
+                W[(i * m + i) * L + l] = sqrt(temp[l]);
+        }
+
+        /* SolveReNewtonSystem */
+        for (int k = 0; k < n; ++k)
+            for (int l = 0; l < L; ++l)
+                workspace[k * L + l] = resids_x[k * L + l] * Dinv[k * L + l];
+        for (int i = 0; i < alphsize; ++i)
+            for (int j = 0; j < alphsize; ++j)
+                for (int l = 0; l < L; ++l)
+                    resids_z[j * L + l] += -1.0 * workspace[(i * alphsize + j) * L + l];
+        for (int i = 1; i < alphsize; ++i)
+            for (int j = 0; j < alphsize; ++j)
+                for (int l = 0; l < L; ++l)
+                    resids_z[(i + alphsize - 1) * L + l] += -1.0 * workspace[(i * alphsize + j) * L + l];
+        for (int k = 0; k < n; ++k)
+            for (int l = 0; l < L; ++l)
+                resids_z[mA * L + l] -= grads1[k * L + l] * workspace[k * L + l];
+
+        /* Nlm_SolveLtriangPosDef */
+        for (int i = 0; i < m; ++i) {
+            double temp[L];
+            for (int l = 0; l < L; ++l)
+                temp[l] = resids_z[i * L + l];
+            for (int j = 0; j < i; ++j)
+                for (int l = 0; l < L; ++l)
+                    temp[l] -= W[(i * m + j) * L + l] * resids_z[j * L + l];
+            for (int l = 0; l < L; ++l)
+                resids_z[i * L + l] = temp[l] / W[(i * m + i) * L + l];
+        }
+        for (int j = m - 1; j >= 0; --j) {
+            for (int l = 0; l < L; ++l)
+                resids_z[j * L + l] /= W[(j * m + j) * L + l];
+            for (int i = 0; i < j; ++i)
+                for (int l = 0; l < L; ++l)
+                    resids_z[i * L + l] -= W[(j * m + i) * L + l] * resids_z[j * L + l];
+        }
+
+        for (int k = 0; k < n; ++k)
+            for (int l = 0; l < L; ++l)
+                resids_x[k * L + l] += grads1[k * L + l] * resids_z[mA * L + l];
+        for (int i = 0; i < alphsize; ++i)
+            for (int j = 0; j < alphsize; ++j) {
+                const int k = i * alphsize + j;
+                for (int l = 0; l < L; ++l) {
+                    resids_x[k * L + l] += 1.0 * resids_z[j * L + l];
+                    if (i > 0)
+                        resids_x[k * L + l] += 1.0 * resids_z[(i + alphsize - 1) * L + l];
+                }
+            }
+        for (int k = 0; k < n; ++k)
+            for (int l = 0; l < L; ++l)
+                resids_x[k * L + l] *= Dinv[k * L + l];
+
+        /* Nlm_StepBound and update of the lanes that take a step */
+        for (int l = 0; l < L; ++l)
+            alpha[l] = 1.0 / .95;
+        for (int k = 0; k < n; ++k)
+            for (int l = 0; l < L; ++l) {
+                const double alpha_i = -x[k * L + l] / resids_x[k * L + l];
+                if (alpha_i >= 0 && alpha_i < alpha[l])
+                    alpha[l] = alpha_i;
+            }
+        for (int l = 0; l < L; ++l)
+            alpha[l] *= 0.95;
+        for (int k = 0; k < n; ++k)
+            for (int l = 0; l < L; ++l)
+                if (step[l])
+                    x[k * L + l] += alpha[l] * resids_x[k * L + l];
+        for (int k = 0; k < m; ++k)
+            for (int l = 0; l < L; ++l)
+                if (step[l])
+                    z[k * L + l] += alpha[l] * resids_z[k * L + l];
+    }
+}
+
 
 /** 180 degrees in half a circle */
 #define HALF_CIRCLE_DEGREES 180
@@ -1295,4 +1563,45 @@ vector<int> CompositionMatrixAdjust(int query_len, int target_len, const double*
     return v;
 }
 
+vector<vector<int>> CompositionMatrixAdjust(int query_len, const vector<int>& target_len, const double* query_comp, const vector<const double*>& target_comp, int scale, double ungapped_lambda, const double* joint_probs, const double* background_freqs) {
+    const size_t count = target_len.size();
+    vector<vector<int>> out(count);
+    double row_probs[COMPO_NUM_TRUE_AA], col_probs[BATCH_LANES][COMPO_NUM_TRUE_AA];
+    std::copy(query_comp, query_comp + COMPO_NUM_TRUE_AA, row_probs);
+    Blast_ApplyPseudocounts(row_probs, query_len, background_freqs);
+    vector<double> row_sums(COMPO_NUM_TRUE_AA * BATCH_LANES), col_sums(COMPO_NUM_TRUE_AA * BATCH_LANES), x(TRUE_AA * TRUE_AA * BATCH_LANES), mat_final(TRUE_AA * TRUE_AA);
+    int status[BATCH_LANES];
+    vector<int*> p(AMINO_ACID_COUNT);
+    for (size_t begin = 0; begin < count; begin += BATCH_LANES) {
+        const int lanes = (int)std::min(count - begin, (size_t)BATCH_LANES);
+        for (int l = 0; l < BATCH_LANES; ++l) {
+            // Unused lanes of the last batch repeat its last problem.
+            const size_t t = begin + std::min(l, lanes - 1);
+            std::copy(target_comp[t], target_comp[t] + COMPO_NUM_TRUE_AA, col_probs[l]);
+            Blast_ApplyPseudocounts(col_probs[l], target_len[t], background_freqs);
+            for (int i = 0; i < COMPO_NUM_TRUE_AA; ++i) {
+                row_sums[i * BATCH_LANES + l] = row_probs[i];
+                col_sums[i * BATCH_LANES + l] = col_probs[l][i];
+            }
+        }
+        OptimizeTargetFrequenciesBatch(x.data(), status, joint_probs, row_sums.data(), col_sums.data(), kFixedReBlosum62, config.cbs_err_tolerance, config.cbs_it_limit);
+        for (int l = 0; l < lanes; ++l) {
+            vector<int>& v = out[begin + l];
+            v.resize(AMINO_ACID_COUNT * AMINO_ACID_COUNT);
+            for (size_t i = 0; i < AMINO_ACID_COUNT; ++i)
+                p[i] = &v[i * AMINO_ACID_COUNT];
+            for (size_t k = 0; k < TRUE_AA * TRUE_AA; ++k)
+                mat_final[k] = x[k * BATCH_LANES + l];
+            int r = status[l];
+            if (r == 0)
+                r = s_ScoresStdAlphabet(p.data(), AMINO_ACID_COUNT, mat_final.data(), row_probs, col_probs[l], ungapped_lambda / scale);
+            if (r != 0)
+                for (size_t i = 0; i < AMINO_ACID_COUNT; ++i)
+                    for (size_t j = 0; j < AMINO_ACID_COUNT; ++j)
+                        v[i * AMINO_ACID_COUNT + j] = score_matrix(i, j) * scale;
+        }
+    }
+    return out;
+}
+
 }
\ No newline at end of file
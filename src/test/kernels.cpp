@@ -0,0 +1,79 @@
+/****
+DIAMOND protein aligner
+Copyright (C) 2022 Max Planck Society for the Advancement of Science e.V.
+
+Code developed by Benjamin Buchfink <benjamin.buchfink@tue.mpg.de>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****/
+
+#include <random>
+#include <vector>
+#include "test.h"
+#include "../basic/value.h"
+#include "../search/finger_print.h"
+#include "../search/search.h"
+#include "../util/simd/dispatch.h"
+
+using std::vector;
+
+// Checks of the vectorized kernels against their scalar counterparts, run by the test command. Each check is compiled
+// for every instruction set and dispatched to the one used by the search.
+
+namespace Test { namespace DISPATCH_ARCH {
+
+// Dispatched stage 1 fingerprint comparison against the scalar match count.
+bool fingerprint_match() {
+	std::minstd_rand0 rand_engine(1);
+	std::uniform_int_distribution<int> letter(0, 24), threshold(0, 48), count(1, 16), percent(0, 99);
+	vector<vector<Letter>> seqs(17, vector<Letter>(48));
+	for (int round = 0; round < 10000; ++round) {
+		for (Letter& l : seqs[0])
+			l = Letter(letter(rand_engine));
+		for (size_t i = 1; i < seqs.size(); ++i) {
+			const int id = percent(rand_engine);
+			for (size_t j = 0; j < 48; ++j) {
+				seqs[i][j] = percent(rand_engine) < id ? seqs[0][j] : Letter(letter(rand_engine));
+				if (percent(rand_engine) < 5)
+					seqs[i][j] |= SEED_MASK;
+			}
+		}
+		const Letter* targets[16];
+		for (int k = 0; k < 16; ++k)
+			targets[k] = seqs[k + 1].data() + 16;
+		const uint32_t n = count(rand_engine);
+		const unsigned t = threshold(rand_engine);
+		const FingerPrint q(seqs[0].data() + 16);
+		uint32_t expected = 0;
+		for (uint32_t k = 0; k < n; ++k)
+			expected |= uint32_t(q.match(FingerPrint(targets[k])) >= t) << k;
+		if (Search::match_fingerprints(seqs[0].data() + 16, targets, n, t) != expected)
+			return false;
+	}
+	return true;
+}
+
+}
+
+DISPATCH_0(bool, fingerprint_match)
+
+#if ARCH_ID == 0
+
+const vector<KernelCheck> kernel_checks = {
+	{ "Stage 1 fingerprint comparison", fingerprint_match }
+};
+
+#endif
+
+}
@@ -92,6 +92,16 @@ static size_t run_testcase(size_t i, shared_ptr<SequenceFile> &db, shared_ptr<Se
 	return 0;
 }
 
+static bool run_kernel_check(const KernelCheck& check, size_t max_width) {
+	const bool passed = check.run();
+	cout << std::setw(max_width) << std::left << check.desc << " [ ";
+	set_color(passed ? Color::GREEN : Color::RED);
+	cout << (passed ? "Passed" : "Failed");
+	reset_color();
+	cout << " ]" << endl;
+	return passed;
+}
+
 static void load_seqs(SequenceFile& file) {
 	file.init_write();
 	for (size_t i = 0; i < seqs.size(); ++i)
@@ -115,10 +125,21 @@ int run() {
 		passed += run_testcase(i, db, query_file, max_width, bootstrap, log, to_cout);
 
 	cout << endl << "#Test cases passed: " << passed << '/' << n << endl; // << endl;
+
+	size_t checks_passed = 0;
+	if (!bootstrap && !to_cout) {
+		const size_t check_width = std::accumulate(kernel_checks.begin(), kernel_checks.end(), (size_t)0, [](size_t l, const KernelCheck& c) { return std::max(l, strlen(c.desc)); });
+		cout << endl;
+		for (const KernelCheck& check : kernel_checks)
+			checks_passed += run_kernel_check(check, check_width);
+		cout << endl << "#Kernel checks passed: " << checks_passed << '/' << kernel_checks.size() << endl;
+	}
+	else
+		checks_passed = kernel_checks.size();
 	
 	query_file->close();
 	db->close();
-	return passed == n ? 0 : 1;
+	return passed == n && checks_passed == kernel_checks.size() ? 0 : 1;
 }
 
 }
\ No newline at end of file
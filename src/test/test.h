@@ -32,11 +32,17 @@ struct TestCase {
 	const char *desc, *command_line;
 };
 
+struct KernelCheck {
+	const char* desc;
+	bool (*run)();
+};
+
 std::vector<Letter> generate_random_seq(size_t length, std::minstd_rand0 &rand_engine);
 std::vector<Letter> simulate_homolog(const Sequence &seq, double id, std::minstd_rand0 &random_engine);
 
 extern const std::vector<std::pair<std::string, std::string>> seqs;
 extern const std::vector<TestCase> test_cases;
 extern const std::vector<uint64_t> ref_hashes;
+extern const std::vector<KernelCheck> kernel_checks;
 
 }
\ No newline at end of file
@@ -25,6 +25,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../intrin.h"
 #include "../system/endianness.h"
 
+inline size_t varint_size(uint32_t x)
+{
+	return x < 1 << 7 ? 1 : (x < 1 << 14 ? 2 : (x < 1 << 21 ? 3 : (x < 1 << 28 ? 4 : 5)));
+}
+
 template<typename _out>
 inline void write_varint(uint32_t x, _out &out)
 {
@@ -24,7 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 template<typename T>
 struct MemBuffer {
 
-	enum { ALIGN = 32 };
+	enum { ALIGN = 64 };
 
 	typedef T value_type;
 
@@ -58,6 +58,15 @@ struct MemBuffer {
 		return size_;
 	}
 
+	// Releases the allocation if it holds more than n elements.
+	void shrink(size_t n) {
+		if (alloc_size_ > n) {
+			Util::Memory::aligned_free(data_);
+			data_ = nullptr;
+			size_ = alloc_size_ = 0;
+		}
+	}
+
 	T* begin() {
 		return data_;
 	}
@@ -81,6 +81,11 @@ void ZlibSource::rewind()
 	init();
 }
 
+bool ZlibSource::wait_readable(int timeout_ms)
+{
+	return strm.avail_in > 0 || eos_ || prev_->wait_readable(timeout_ms);
+}
+
 ZlibSink::ZlibSink(StreamEntity *prev):
 	StreamEntity(prev)
 {
@@ -111,6 +116,12 @@ void ZlibSink::write(const char * ptr, size_t count)
 	deflate_loop(ptr, count, Z_NO_FLUSH);
 }
 
+void ZlibSink::sync()
+{
+	deflate_loop(0, 0, Z_SYNC_FLUSH);
+	prev_->sync();
+}
+
 void ZlibSink::close()
 {
 	deflate_loop(0, 0, Z_FINISH);
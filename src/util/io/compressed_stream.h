@@ -27,6 +27,7 @@ struct ZlibSource : public StreamEntity
 	virtual size_t read(char *ptr, size_t count);
 	virtual void close();
 	virtual void rewind();
+	virtual bool wait_readable(int timeout_ms);
 private:
 	void init();
 	z_stream strm;
@@ -39,6 +40,7 @@ struct ZlibSink : public StreamEntity
 	ZlibSink(StreamEntity *prev);
 	virtual void close();
 	virtual void write(const char *ptr, size_t count);
+	virtual void sync();
 private:
 	void deflate_loop(const char *ptr, size_t count, int code);
 	static const size_t chunk_size = 1llu << 20;
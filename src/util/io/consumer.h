@@ -3,5 +3,6 @@
 struct Consumer {
 	virtual void consume(const char *ptr, size_t n) = 0;
 	virtual void finalize() {}
+	virtual void sync() {}
 	virtual ~Consumer() = default;
 };
\ No newline at end of file
@@ -88,6 +88,15 @@ size_t Deserializer::read_raw(char *ptr, size_t count)
 	return total;
 }
 
+size_t Deserializer::read_available(char* ptr, size_t count)
+{
+	if (avail() == 0 && (buffer_ == NULL || !fetch()))
+		return 0;
+	const size_t n = std::min(count, avail());
+	pop(ptr, n);
+	return n;
+}
+
 bool Deserializer::fetch()
 {
 	if (buffer_ == NULL)
@@ -216,6 +216,12 @@ struct Deserializer
 	}
 
 	size_t read_raw(char *ptr, size_t count);
+	// Reads up to count bytes, fetching from the stream only if no data is buffered. Returns 0 at the end of the stream.
+	size_t read_available(char* ptr, size_t count);
+	// Returns true if data can be read without blocking, waiting up to timeout_ms milliseconds for input.
+	bool wait_readable(int timeout_ms) {
+		return avail() > 0 || buffer_ == NULL || buffer_->wait_readable(timeout_ms);
+	}
 	DynamicRecordReader read_record();
 	int64_t file_size() {
 		return buffer_->file_size();
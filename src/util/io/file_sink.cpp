@@ -114,6 +114,17 @@ void FileSink::write(const char *ptr, size_t count)
 	if (async_) mtx_.unlock();
 }
 
+void FileSink::sync()
+{
+	if (async_) mtx_.lock();
+	const int r = fflush(f_);
+	if (async_) mtx_.unlock();
+	if (r != 0) {
+		perror(0);
+		throw File_write_exception(file_name_);
+	}
+}
+
 void FileSink::seek(int64_t p, int origin)
 {
 #ifdef _MSC_VER
@@ -37,6 +37,7 @@ struct FileSink : public StreamEntity
 	virtual void seek(int64_t p, int origin = SEEK_SET) override;
 	virtual void rewind() override;
 	virtual int64_t tell() override;
+	virtual void sync() override;
 	virtual const std::string& file_name() const override
 	{
 		return file_name_;
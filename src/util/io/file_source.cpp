@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <poll.h>
 #endif
 
 #include "file_source.h"
@@ -37,7 +38,9 @@ using std::runtime_error;
 
 FileSource::FileSource(const string &file_name) :
 	StreamEntity(true),
-	file_name_(file_name)
+	file_name_(file_name),
+	fd_(-1),
+	pipe_(false)
 {
 	static const char* msg = "\nError opening file ";
 	const bool is_stdin = file_name.empty() || file_name == "-";
@@ -50,10 +53,12 @@ FileSource::FileSource(const string &file_name) :
 		perror((msg + file_name).c_str());
 		throw FileOpenException(file_name);
 	}
-	if (is_stdin || !S_ISREG(buf.st_mode))
+	if (is_stdin || !S_ISREG(buf.st_mode)) {
 		seekable_ = false;
+		pipe_ = true;
+	}
 
-	int fd_ = is_stdin ? 0 : POSIX_OPEN2(file_name.c_str(), O_RDONLY);
+	fd_ = is_stdin ? 0 : POSIX_OPEN2(file_name.c_str(), O_RDONLY);
 	if (fd_ < 0) {
 		perror((msg + file_name).c_str());
 		throw FileOpenException(file_name);
@@ -64,12 +69,19 @@ FileSource::FileSource(const string &file_name) :
 		perror((msg + file_name).c_str());
 		throw FileOpenException(file_name);
 	}
+#ifndef _MSC_VER
+	// Pipes are read from the descriptor, the stream is kept unbuffered so that it never holds input read ahead.
+	if (pipe_)
+		setvbuf(f_, nullptr, _IONBF, 0);
+#endif
 }
 
 FileSource::FileSource(const string &file_name, FILE *file):
 	StreamEntity(false),
 	f_(file),
-	file_name_(file_name)
+	file_name_(file_name),
+	fd_(-1),
+	pipe_(false)
 {
 }
 
@@ -103,6 +115,19 @@ void FileSource::seek(int64_t pos, int origin)
 
 size_t FileSource::read(char *ptr, size_t count)
 {
+#ifndef _MSC_VER
+	if (pipe_) {
+		// Return the data that is available instead of blocking until the buffer is full, so that
+		// streamed input can be processed as it arrives.
+		ssize_t m;
+		while ((m = ::read(fd_, ptr, count)) < 0 && errno == EINTR);
+		if (m < 0) {
+			perror(0);
+			throw File_read_exception(file_name_);
+		}
+		return (size_t)m;
+	}
+#endif
 	size_t n;
 	if ((n = fread(ptr, 1, count, f_)) != count) {
 		if (feof(f_) != 0)
@@ -115,6 +140,21 @@ size_t FileSource::read(char *ptr, size_t count)
 	return n;
 }
 
+bool FileSource::wait_readable(int timeout_ms)
+{
+#ifndef _MSC_VER
+	if (pipe_) {
+		pollfd p;
+		p.fd = fd_;
+		p.events = POLLIN;
+		int r;
+		while ((r = poll(&p, 1, timeout_ms)) < 0 && errno == EINTR);
+		return r != 0;
+	}
+#endif
+	return true;
+}
+
 void FileSource::close()
 {
 	if (f_) {
@@ -27,6 +27,7 @@ struct FileSource : public StreamEntity
 	virtual void seek(int64_t p, int origin) override;
 	virtual int64_t tell() override;
 	virtual size_t read(char *ptr, size_t count) override;
+	virtual bool wait_readable(int timeout_ms) override;
 	virtual void close() override;
 	virtual int64_t file_size() override;
 	virtual const std::string& file_name() const override
@@ -43,4 +44,6 @@ struct FileSource : public StreamEntity
 protected:
 	FILE *f_;
 	const std::string file_name_;
+	int fd_;
+	bool pipe_;
 };
\ No newline at end of file
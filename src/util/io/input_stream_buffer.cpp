@@ -101,4 +101,9 @@ int64_t InputStreamBuffer::tell() {
 	if (!seekable())
 		throw std::runtime_error("Calling tell on non seekable stream.");
 	return file_offset_;
-}
\ No newline at end of file
+}
+
+bool InputStreamBuffer::wait_readable(int timeout_ms) {
+	// A pending load may block, it is not waited for here.
+	return putback_count_ > 0 || load_worker_ || prev_->wait_readable(timeout_ms);
+}
@@ -35,6 +35,7 @@ struct InputStreamBuffer : public StreamEntity
 	virtual void putback(const char* p, size_t n) override;
 	virtual void close() override;
 	virtual int64_t tell() override;
+	virtual bool wait_readable(int timeout_ms) override;
 private:
 
 	static void load_worker(InputStreamBuffer *buf);
@@ -125,4 +125,10 @@ void Serializer::consume(const char *ptr, size_t n) {
 
 void Serializer::finalize() {
 	close();
+}
+
+void Serializer::sync() {
+	flush();
+	reset_buffer();
+	buffer_->sync();
 }
\ No newline at end of file
@@ -167,6 +167,7 @@ struct Serializer : public Consumer
 	FILE* file();
 	virtual void consume(const char *ptr, size_t n) override;
 	virtual void finalize() override;
+	virtual void sync() override;
 	~Serializer();
 
 protected:
@@ -75,6 +75,18 @@ struct StreamEntity
 	{
 		throw UnsupportedOperation();
 	}
+	// Returns true if read() will return data (or the end of the stream) without blocking, waiting up to timeout_ms
+	// milliseconds for input to arrive. Streams that cannot tell return true.
+	virtual bool wait_readable(int timeout_ms)
+	{
+		return prev_ ? prev_->wait_readable(timeout_ms) : true;
+	}
+	// Passes all data written so far down to the underlying file.
+	virtual void sync()
+	{
+		if (prev_)
+			prev_->sync();
+	}
 	virtual int64_t file_size() {
 		if (prev_)
 			return prev_->file_size();
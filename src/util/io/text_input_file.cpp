@@ -76,7 +76,7 @@ void TextInputFile::getline()
 		const char *p = (const char*)memchr(&line_buf_[line_buf_used_], '\n', line_buf_end_ - line_buf_used_);
 		if (p == 0) {
 			line.append(&line_buf_[line_buf_used_], line_buf_end_ - line_buf_used_);
-			line_buf_end_ = read(line_buf_, line_buf_size);
+			line_buf_end_ = read_available(line_buf_, line_buf_size);
 			line_buf_used_ = 0;
 			if (line_buf_end_ == 0) {
 				eof_ = true;
@@ -32,6 +32,10 @@ struct TextInputFile : public InputFile
 	void putback(char c);
 	void getline();
 	void putback_line();
+	// Returns true if more input than the putback line is available, waiting up to timeout_ms milliseconds.
+	bool wait_readable(int timeout_ms) {
+		return line_buf_used_ < line_buf_end_ || Deserializer::wait_readable(timeout_ms);
+	}
 	operator bool() const {
 		return !eof();
 	}
@@ -28,6 +28,22 @@ void ZstdSink::write(const char* ptr, size_t count)
 	} while (in_buf.pos < in_buf.size);
 }
 
+void ZstdSink::sync()
+{
+	ZSTD_outBuffer out_buf;
+	size_t n;
+	do {
+		pair<char*, char*> out = prev_->write_buffer();
+		out_buf.dst = out.first;
+		out_buf.size = out.second - out.first;
+		out_buf.pos = 0;
+		if (ZSTD_isError(n = ZSTD_flushStream(stream, &out_buf)))
+			throw std::runtime_error("ZSTD_flushStream");
+		prev_->flush(out_buf.pos);
+	} while (n > 0);
+	prev_->sync();
+}
+
 void ZstdSink::close()
 {
 	if (!stream)
@@ -100,4 +116,9 @@ void ZstdSource::rewind()
 {
 	prev_->rewind();
 	init();
-}
\ No newline at end of file
+}
+
+bool ZstdSource::wait_readable(int timeout_ms)
+{
+	return in_buf.pos < in_buf.size || eos_ || prev_->wait_readable(timeout_ms);
+}
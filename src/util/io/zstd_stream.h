@@ -7,6 +7,7 @@ struct ZstdSink : public StreamEntity
 	ZstdSink(StreamEntity* prev);
 	virtual void close();
 	virtual void write(const char* ptr, size_t count);
+	virtual void sync();
 private:
 	ZSTD_CStream* stream;
 };
@@ -17,6 +18,7 @@ struct ZstdSource : public StreamEntity
 	virtual size_t read(char* ptr, size_t count);
 	virtual void close();
 	virtual void rewind();
+	virtual bool wait_readable(int timeout_ms);
 private:
 	void init();
 	ZSTD_DStream* stream;
@@ -20,14 +20,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 #include <array>
+#include <cstddef>
 #include <thread>
 #include <atomic>
 #include <vector>
-#include <queue>
+#include <deque>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include <mutex>
 #include <condition_variable>
 #include <numeric>
 #include <functional>
 #include "../log_stream.h"
+#include "../system/system.h"
 
 namespace Util { namespace Parallel {
 
@@ -44,7 +51,10 @@ void scheduled_thread_pool(size_t thread_count, F f, Args... args) {
 	std::atomic<size_t> partition(0);
 	std::vector<std::thread> threads;
 	for (size_t i = 0; i < thread_count; ++i)
-		threads.emplace_back(f, &partition, i, args...);
+		threads.emplace_back([&partition, i, thread_count, f, args...]() {
+			bind_thread(i, thread_count);
+			f(&partition, i, args...);
+		});
 	for (std::thread &t : threads)
 		t.join();
 }
@@ -79,8 +89,11 @@ struct ThreadPool {
 		void finish() {
 			++finished_;
 			if (finished()) {
+				{
+					std::lock_guard<std::mutex> lock(mtx_);
+				}
 				cv_.notify_all();
-				thread_pool->cv_.notify_all();
+				thread_pool->notify_all();
 			}
 		}
 		bool finished() const {
@@ -114,76 +127,143 @@ struct ThreadPool {
 		friend struct ThreadPool;
 	};
 
+	// Type erased callable that keeps small function objects in place to avoid a heap allocation per task.
 	struct Task {
+		enum { STORAGE_SIZE = 96 };
 		Task():
-			task_set(nullptr)
-		{}
-		Task(std::function<void()> f):
-			f(f),
-			task_set(nullptr)
-		{}
-		Task(std::function<void()> f, TaskSet& task_set):
-			f(f),
-			task_set(&task_set)
+			task_set(nullptr),
+			invoke_(nullptr),
+			manage_(nullptr)
 		{}
+		template<typename F>
+		Task(F&& f, TaskSet* task_set):
+			task_set(task_set)
+		{
+			using Fn = typename std::decay<F>::type;
+			if (sizeof(Fn) <= STORAGE_SIZE && alignof(Fn) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<Fn>::value) {
+				new (storage_) Fn(std::forward<F>(f));
+				invoke_ = [](void* p) { (*reinterpret_cast<Fn*>(p))(); };
+				manage_ = [](void* dst, void* src) {
+					if (dst)
+						new (dst) Fn(std::move(*reinterpret_cast<Fn*>(src)));
+					reinterpret_cast<Fn*>(src)->~Fn();
+				};
+			}
+			else {
+				*reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(f));
+				invoke_ = [](void* p) { (**reinterpret_cast<Fn**>(p))(); };
+				manage_ = [](void* dst, void* src) {
+					if (dst)
+						*reinterpret_cast<Fn**>(dst) = *reinterpret_cast<Fn**>(src);
+					else
+						delete *reinterpret_cast<Fn**>(src);
+				};
+			}
+		}
+		Task(Task&& t) noexcept:
+			task_set(t.task_set),
+			invoke_(t.invoke_),
+			manage_(t.manage_)
+		{
+			if (manage_)
+				manage_(storage_, t.storage_);
+			t.invoke_ = nullptr;
+			t.manage_ = nullptr;
+		}
+		Task& operator=(Task&& t) noexcept {
+			if (this != &t) {
+				reset();
+				task_set = t.task_set;
+				invoke_ = t.invoke_;
+				manage_ = t.manage_;
+				if (manage_)
+					manage_(storage_, t.storage_);
+				t.invoke_ = nullptr;
+				t.manage_ = nullptr;
+			}
+			return *this;
+		}
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+		~Task() {
+			reset();
+		}
 		operator bool() const {
-			return f.operator bool();
+			return invoke_ != nullptr;
+		}
+		void operator()() {
+			invoke_(storage_);
 		}
-		std::function<void()> f;
 		TaskSet* task_set;
+	private:
+		void reset() {
+			if (manage_)
+				manage_(nullptr, storage_);
+			invoke_ = nullptr;
+			manage_ = nullptr;
+		}
+		alignas(std::max_align_t) char storage_[STORAGE_SIZE];
+		void (*invoke_)(void*);
+		void (*manage_)(void*, void*);
 	};
 
 	template<class F, class... Args>
 	void enqueue(TaskSet& task_set, F&& f, Args&&... args)
 	{
-		auto task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
+		task_set.add();
+		BoundTask<typename std::decay<F>::type, typename std::decay<Args>::type...> task(std::forward<F>(f), std::forward<Args>(args)...);
+		WorkQueue& q = *queues_[local_queue()];
 		{
-			std::unique_lock<std::mutex> lock(mtx_);
-
-			/*if (stop_)
-				throw std::runtime_error("enqueue on stopped ThreadPool");*/
-
-			task_set.add();
-			tasks_[task_set.priority].emplace([task]() { task(); }, task_set);
+			std::lock_guard<std::mutex> lock(q.mtx);
+			q.tasks[task_set.priority].emplace_back(std::move(task), &task_set);
 		}
-		cv_.notify_one();
+		++queued_[task_set.priority];
+		notify_one(task_set.priority);
 	}
 
 	void run_set(TaskSet* task_set) {
+		const int priority = task_set ? task_set->priority : PRIORITY_COUNT - 1;
 		for (;;)
 		{
 			Task task;
 
 			if (!task_set && run_default_) {
-				if (!queue_empty()) {
-					std::unique_lock<std::mutex> lock(this->mtx_);
-					task = pop_task();
-				}
+				task = pop_task(priority);
 				if (!task) {
 					++default_started_;
 					if (!default_task_(*this))
 						run_default_ = false;
 					++default_finished_;
 					if (!run_default_ && default_started_ == default_finished_) {
-						stop_ = true;
-						cv_.notify_all();
+						{
+							std::lock_guard<std::mutex> lock(mtx_);
+							stop_ = true;
+						}
+						notify_waiters();
 					}
 					continue;
 				}
 			}
 			else {
-				std::unique_lock<std::mutex> lock(this->mtx_);
-				this->cv_.wait(lock,
-					[this, task_set] { return (stop_ && !task_set) || !queue_empty(task_set ? task_set->priority : PRIORITY_COUNT-1) || (task_set && task_set->finished()); });
-				if ((stop_ && queue_empty() && !task_set) || (task_set && task_set->finished())) {
-					if (!task_set)
-						++threads_finished_;
+				if (task_set && task_set->finished())
 					return;
+				task = pop_task(priority);
+				if (!task) {
+					std::unique_lock<std::mutex> lock(this->mtx_);
+					++sleeping_[priority];
+					this->cv_[priority].wait(lock,
+						[this, task_set, priority] { return (stop_ && !task_set) || !queue_empty(priority) || (task_set && task_set->finished()); });
+					--sleeping_[priority];
+					if ((stop_ && queue_empty() && !task_set) || (task_set && task_set->finished())) {
+						if (!task_set)
+							++threads_finished_;
+						return;
+					}
+					continue;
 				}
-				task = pop_task(task_set ? task_set->priority : PRIORITY_COUNT - 1);
 			}
 
-			task.f();
+			task();
 			if (task.task_set)
 				task.task_set->finish();
 		}
@@ -198,11 +278,23 @@ struct ThreadPool {
 		default_finished_(0),
 		threads_finished_(0)
 	{
+		for (auto& i : queued_)
+			i = 0;
+		for (auto& i : sleeping_)
+			i = 0;
+		queues_.emplace_back(new WorkQueue);
 	}
 
 	void run(size_t threads, bool heartbeat = false) {
+		const size_t first = queues_.size();
+		for (size_t i = 0; i < threads; ++i)
+			queues_.emplace_back(new WorkQueue);
 		for (size_t i = 0; i < threads; ++i)
-			workers_.emplace_back([this] {	this->run_set(nullptr); });
+			workers_.emplace_back([this, i, threads, first] {
+				bind_thread(i, threads);
+				worker_queue() = { this, first + i };
+				this->run_set(nullptr);
+			});
 		if (heartbeat)
 			heartbeat_ = std::thread([&]() {
 			while (!stop_) {
@@ -218,7 +310,7 @@ struct ThreadPool {
 			std::unique_lock<std::mutex> lock(mtx_);
 			stop_ = true;
 		}
-		cv_.notify_all();
+		notify_waiters();
 		join();
 	}
 
@@ -231,36 +323,127 @@ struct ThreadPool {
 	}
 
 	int64_t queue_len(int priority) const {
-		return tasks_[priority].size();
+		return queued_[priority];
 	}
 
 private:
 
-	bool queue_empty(int priority = PRIORITY_COUNT - 1) {
+	// Queue 0 receives tasks enqueued from threads outside the pool, the others are owned by one worker each.
+	// A worker pops its own queue from the back and steals from the front of the other queues.
+	struct WorkQueue {
+		std::mutex mtx;
+		std::array<std::deque<Task>, PRIORITY_COUNT> tasks;
+	};
+
+	template<size_t... I>
+	struct IndexSequence {};
+
+	template<size_t N, size_t... I>
+	struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, I...> {};
+
+	template<size_t... I>
+	struct MakeIndexSequence<0, I...> {
+		using Type = IndexSequence<I...>;
+	};
+
+	// A function object with its arguments bound by value.
+	template<typename F, typename... Args>
+	struct BoundTask {
+		template<typename G, typename... A>
+		BoundTask(G&& f, A&&... args):
+			f(std::forward<G>(f)),
+			args(std::forward<A>(args)...)
+		{}
+		void operator()() {
+			call(typename MakeIndexSequence<sizeof...(Args)>::Type());
+		}
+	private:
+		template<size_t... I>
+		void call(IndexSequence<I...>) {
+			f(std::get<I>(args)...);
+		}
+		F f;
+		std::tuple<Args...> args;
+	};
+
+	static std::pair<const ThreadPool*, size_t>& worker_queue() {
+		static thread_local std::pair<const ThreadPool*, size_t> q(nullptr, 0);
+		return q;
+	}
+
+	size_t local_queue() const {
+		const std::pair<const ThreadPool*, size_t>& q = worker_queue();
+		return q.first == this ? q.second : 0;
+	}
+
+	void notify_all() {
+		{
+			std::lock_guard<std::mutex> lock(mtx_);
+		}
+		notify_waiters();
+	}
+
+	void notify_waiters() {
+		for (std::condition_variable& cv : cv_)
+			cv.notify_all();
+	}
+
+	// Wakes one sleeping worker that accepts tasks of the given priority, if there is one. A thread waiting in
+	// run_set() for tasks up to priority p sleeps on cv_[p] and is counted in sleeping_[p].
+	void notify_one(int priority) {
+		for (int p = priority; p < PRIORITY_COUNT; ++p)
+			if (sleeping_[p] > 0) {
+				{
+					std::lock_guard<std::mutex> lock(mtx_);
+				}
+				cv_[p].notify_one();
+				return;
+			}
+	}
+
+	bool queue_empty(int priority = PRIORITY_COUNT - 1) const {
 		for (int i = 0; i <= priority; ++i)
-			if (!tasks_[i].empty())
+			if (queued_[i] > 0)
 				return false;
 		return true;
 	}
 
 	Task pop_task(int priority = PRIORITY_COUNT - 1) {
-		Task task;
-		for (int i = 0; i <= priority; ++i)
-			if (!tasks_[i].empty()) {
-				task = std::move(tasks_[i].front());
-				tasks_[i].pop();
-				break;
+		const size_t n = queues_.size(), own = local_queue();
+		for (int i = 0; i <= priority; ++i) {
+			if (queued_[i] <= 0)
+				continue;
+			for (size_t j = 0; j < n; ++j) {
+				WorkQueue& q = *queues_[(own + j) % n];
+				std::lock_guard<std::mutex> lock(q.mtx);
+				std::deque<Task>& d = q.tasks[i];
+				if (d.empty())
+					continue;
+				Task task;
+				if (j == 0 && own != 0) {
+					task = std::move(d.back());
+					d.pop_back();
+				}
+				else {
+					task = std::move(d.front());
+					d.pop_front();
+				}
+				--queued_[i];
+				return task;
 			}
-		return task;
+		}
+		return Task();
 	}
 
-	std::array<std::queue<Task>, PRIORITY_COUNT> tasks_;
+	std::vector<std::unique_ptr<WorkQueue>> queues_;
+	std::array<std::atomic<int64_t>, PRIORITY_COUNT> queued_;
 	std::function<bool(ThreadPool&)> default_task_;
 	std::vector<std::thread> workers_;
 	std::thread heartbeat_;
 	std::mutex mtx_;
-	std::condition_variable cv_;
-	bool stop_, run_default_;
+	std::array<std::condition_variable, PRIORITY_COUNT> cv_;
+	std::array<std::atomic<int>, PRIORITY_COUNT> sleeping_;
+	std::atomic<bool> stop_, run_default_;
 	std::atomic<int64_t> default_started_, default_finished_, threads_finished_;
 
 };
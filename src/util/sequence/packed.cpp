@@ -0,0 +1,86 @@
+/****
+DIAMOND protein aligner
+Copyright (C) 2022 Max Planck Society for the Advancement of Science e.V.
+
+Code developed by Benjamin Buchfink <benjamin.buchfink@tue.mpg.de>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****/
+
+#include <string.h>
+#include <stdint.h>
+#include "packed.h"
+#include "../simd.h"
+#include "../simd/dispatch.h"
+
+namespace Util { namespace Seq { namespace DISPATCH_ARCH {
+
+#ifdef __SSSE3__
+
+// Letters 8g..8g+7 occupy bytes 5g..5g+4. Every 16 bit lane receives the two bytes holding its letter, which is then
+// moved to the top of the lane by a multiplication and shifted back down.
+static inline __m128i unpack_lanes(const __m128i bytes, const __m128i shuffle) {
+	const __m128i mul = _mm_setr_epi16(1 << 11, 1 << 6, 1 << 9, 1 << 4, 1 << 7, 1 << 10, 1 << 5, 1 << 8);
+	return _mm_srli_epi16(_mm_mullo_epi16(_mm_shuffle_epi8(bytes, shuffle), mul), 11);
+}
+
+#endif
+
+void unpack(const char* src, size_t len, Letter* dst) {
+	const size_t bytes = packed_size(len);
+	size_t i = 0;
+#ifdef __AVX2__
+	{
+		const __m256i lo = _mm256_setr_epi8(0, 1, 0, 1, 1, 2, 1, 2, 2, 3, 3, 4, 3, 4, 4, 5, 0, 1, 0, 1, 1, 2, 1, 2, 2, 3, 3, 4, 3, 4, 4, 5),
+			hi = _mm256_setr_epi8(5, 6, 5, 6, 6, 7, 6, 7, 7, 8, 8, 9, 8, 9, 9, 10, 5, 6, 5, 6, 6, 7, 6, 7, 7, 8, 8, 9, 8, 9, 9, 10),
+			mul = _mm256_setr_epi16(1 << 11, 1 << 6, 1 << 9, 1 << 4, 1 << 7, 1 << 10, 1 << 5, 1 << 8, 1 << 11, 1 << 6, 1 << 9, 1 << 4, 1 << 7, 1 << 10, 1 << 5, 1 << 8);
+		for (; i + 32 <= len && i / 8 * 5 + 26 <= bytes; i += 32) {
+			const char* p = src + i / 8 * 5;
+			const __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)), _mm_loadu_si128((const __m128i*)(p + 10)), 1);
+			const __m256i a = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_shuffle_epi8(v, lo), mul), 11),
+				b = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_shuffle_epi8(v, hi), mul), 11);
+			_mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(a, b));
+		}
+	}
+#endif
+#ifdef __SSSE3__
+	{
+		const __m128i lo = _mm_setr_epi8(0, 1, 0, 1, 1, 2, 1, 2, 2, 3, 3, 4, 3, 4, 4, 5),
+			hi = _mm_setr_epi8(5, 6, 5, 6, 6, 7, 6, 7, 7, 8, 8, 9, 8, 9, 9, 10);
+		for (; i + 16 <= len && i / 8 * 5 + 16 <= bytes; i += 16) {
+			const __m128i v = _mm_loadu_si128((const __m128i*)(src + i / 8 * 5));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(unpack_lanes(v, lo), unpack_lanes(v, hi)));
+		}
+	}
+#endif
+	for (; i + 8 <= len && i / 8 * 5 + 8 <= bytes; i += 8) {
+		uint64_t v;
+		memcpy(&v, src + i / 8 * 5, 8);
+		for (int k = 0; k < 8; ++k, v >>= PACKED_BITS)
+			dst[i + k] = Letter(v & 31);
+	}
+	for (; i < len; ++i) {
+		const size_t bit = i * PACKED_BITS, byte = bit / 8;
+		uint32_t v = (uint8_t)src[byte];
+		if (byte + 1 < bytes)
+			v |= uint32_t((uint8_t)src[byte + 1]) << 8;
+		dst[i] = Letter((v >> (bit % 8)) & 31);
+	}
+}
+
+}
+
+DISPATCH_3V(unpack, const char*, src, size_t, len, Letter*, dst);
+
+}}
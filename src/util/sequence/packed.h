@@ -0,0 +1,70 @@
+/****
+DIAMOND protein aligner
+Copyright (C) 2022 Max Planck Society for the Advancement of Science e.V.
+
+Code developed by Benjamin Buchfink <benjamin.buchfink@tue.mpg.de>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****/
+
+#pragma once
+#include <stddef.h>
+#include <vector>
+#include "../../basic/value.h"
+#include "../algo/varint.h"
+
+namespace Util { namespace Seq {
+
+// Amino acid letters packed into 5 bits each, least significant bits first.
+constexpr int PACKED_BITS = 5;
+
+static inline size_t packed_size(size_t letters) {
+	return (letters * PACKED_BITS + 7) / 8;
+}
+
+// Appends the varint length of seq and its packed letters to out. The masking bit is not stored, see pack_mask().
+void pack(const Letter* seq, size_t len, std::vector<char>& out);
+
+// Appends the runs of letters carrying the masking bit to out, as the varint number of runs followed by the varint
+// distance to the end of the previous run and the length of each run.
+void pack_mask(const Letter* seq, size_t len, std::vector<char>& out);
+
+// Reads runs written by pack_mask() from in and sets the masking bit of the letters in dst.
+template<typename In>
+void unpack_mask(In& in, Letter* dst) {
+	uint32_t n, d, l;
+	read_varint(in, n);
+	Letter* p = dst;
+	for (uint32_t i = 0; i < n; ++i) {
+		read_varint(in, d);
+		read_varint(in, l);
+		p += d;
+		for (Letter* end = p + l; p < end; ++p)
+			*p |= SEED_MASK;
+	}
+}
+
+// Skips runs written by pack_mask().
+template<typename In>
+void skip_mask(In& in) {
+	uint32_t n, x;
+	read_varint(in, n);
+	for (uint32_t i = 0; i < 2 * n; ++i)
+		read_varint(in, x);
+}
+
+// Unpacks len letters from src (following the length) into dst, reading no more than packed_size(len) bytes.
+void unpack(const char* src, size_t len, Letter* dst);
+
+}}
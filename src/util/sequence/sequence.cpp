@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../util.h"
 #include "../../stats/score_matrix.h"
 #include "translate.h"
+#include "packed.h"
 
 using std::vector;
 using std::array;
@@ -193,4 +194,56 @@ std::vector<Score> window_scores(Sequence seq1, Sequence seq2, Loc window) {
 	return v;
 }
 
-}}
\ No newline at end of file
+namespace {
+
+struct BufferWriter {
+	template<typename T>
+	void write(T x) {
+		out.insert(out.end(), (const char*)&x, (const char*)&x + sizeof(T));
+	}
+	std::vector<char>& out;
+};
+
+}
+
+void pack(const Letter* seq, size_t len, std::vector<char>& out) {
+	BufferWriter w{ out };
+	write_varint((uint32_t)len, w);
+	uint32_t buf = 0;
+	int bits = 0;
+	for (size_t i = 0; i < len; ++i) {
+		buf |= uint32_t(seq[i] & ~SEED_MASK) << bits;
+		bits += PACKED_BITS;
+		while (bits >= 8) {
+			out.push_back(char(buf & 0xff));
+			buf >>= 8;
+			bits -= 8;
+		}
+	}
+	if (bits > 0)
+		out.push_back(char(buf));
+}
+
+void pack_mask(const Letter* seq, size_t len, std::vector<char>& out) {
+	BufferWriter w{ out };
+	vector<std::pair<uint32_t, uint32_t>> runs;
+	size_t last = 0;
+	for (size_t i = 0; i < len;) {
+		if (!(seq[i] & SEED_MASK)) {
+			++i;
+			continue;
+		}
+		const size_t begin = i;
+		while (i < len && (seq[i] & SEED_MASK))
+			++i;
+		runs.emplace_back(uint32_t(begin - last), uint32_t(i - begin));
+		last = i;
+	}
+	write_varint((uint32_t)runs.size(), w);
+	for (const auto& r : runs) {
+		write_varint(r.first, w);
+		write_varint(r.second, w);
+	}
+}
+
+}}
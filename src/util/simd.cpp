@@ -41,6 +41,18 @@ inline void cpuid(int CPUInfo[4], int InfoType) {
 #endif
 #endif
 
+#if defined(WITH_AVX512) && defined(__SSE2__)
+#ifdef _WIN32
+#define xgetbv(x) _xgetbv(x)
+#else
+inline uint64_t xgetbv(unsigned index) {
+	uint32_t eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+	return ((uint64_t)edx << 32) | eax;
+}
+#endif
+#endif
+
 namespace SIMD {
 
 int flags = 0;
@@ -70,6 +82,7 @@ Arch init_arch() {
 	}
 	else
 		throw std::runtime_error("Incompatible CPU type. Please try to compile the software from source.");
+	const int info1_ecx = info[2];
 
 	if ((info[2] & (1 << 9)) != 0)
 		flags |= SSSE3;
@@ -82,7 +95,9 @@ Arch init_arch() {
 		if ((info[1] & (1 << 5)) != 0)
 			flags |= AVX2;
 #ifdef WITH_AVX512
-		if ((info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0)
+		// AVX512F and AVX512BW, and the OS has to save the opmask and ZMM state (XCR0 bits 1, 2, 5, 6, 7)
+		const bool osxsave = (info1_ecx & (1 << 27)) != 0;
+		if ((info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0 && osxsave && (xgetbv(0) & 0xe6) == 0xe6)
 			flags |= AVX512;
 #endif
 	}
@@ -105,7 +120,7 @@ Arch init_arch() {
 		throw std::runtime_error("CPU does not support AVX2. Please compile the software from source.");
 #endif
 
-	if (flags & AVX512)
+	if ((flags & AVX512) && (flags & AVX2) && (flags & SSSE3) && (flags & POPCNT) && (flags & SSE4_1))
 		return Arch::AVX512;
 	if ((flags & SSSE3) && (flags & POPCNT) && (flags & SSE4_1) && (flags & AVX2))
 		return Arch::AVX2;
@@ -133,6 +148,8 @@ std::string features() {
 		r.push_back("sse4.1");
 	if (flags & AVX2)
 		r.push_back("avx2");
+	if (flags & AVX512)
+		r.push_back("avx512f avx512bw");
 	return r.empty() ? "None" : join(" ", r);
 }
 
@@ -1,5 +1,11 @@
 #pragma once
 
+#ifdef WITH_AVX512
+#define HAVE_AVX512(x) x
+#else
+#define HAVE_AVX512(x)
+#endif
+
 #ifdef WITH_AVX2
 #define HAVE_AVX2(x) x
 #else
@@ -19,7 +25,7 @@
 #endif
 
 
-#if defined(WITH_NEON) | defined(WITH_AVX2) | defined(WITH_SSE4_1)
+#if defined(WITH_NEON) | defined(WITH_AVX512) | defined(WITH_AVX2) | defined(WITH_SSE4_1)
 #define HAVE_SIMD(x) x
 #else
 #define HAVE_SIMD(x)
@@ -29,11 +35,13 @@
 
 #define DISPATCH_0V(name)\
 HAVE_SSE4_1(namespace ARCH_SSE4_1 { void name(); })\
+HAVE_AVX512(namespace ARCH_AVX512 { void name(); })\
 HAVE_AVX2(namespace ARCH_AVX2 { void name(); })\
 HAVE_NEON(namespace ARCH_NEON { void name(); })\
 void name() {\
 HAVE_SIMD(switch(::SIMD::arch()) {)\
 HAVE_NEON(case ::SIMD::Arch::NEON: ARCH_NEON::name(); break;)\
+HAVE_AVX512(case ::SIMD::Arch::AVX512: ARCH_AVX512::name(); break;)\
 HAVE_AVX2(case ::SIMD::Arch::AVX2: ARCH_AVX2::name(); break;)\
 HAVE_SSE4_1(case ::SIMD::Arch::SSE4_1: ARCH_SSE4_1::name(); break;)\
 HAVE_SIMD(default:)\
@@ -41,13 +49,31 @@ ARCH_GENERIC::name();\
 HAVE_SIMD(})\
 }
 
+#define DISPATCH_0(ret, name)\
+HAVE_SSE4_1(namespace ARCH_SSE4_1 { ret name(); })\
+HAVE_AVX512(namespace ARCH_AVX512 { ret name(); })\
+HAVE_AVX2(namespace ARCH_AVX2 { ret name(); })\
+HAVE_NEON(namespace ARCH_NEON { ret name(); })\
+ret name() {\
+HAVE_SIMD(switch(::SIMD::arch()) {)\
+HAVE_NEON(case ::SIMD::Arch::NEON: return ARCH_NEON::name();)\
+HAVE_AVX512(case ::SIMD::Arch::AVX512: return ARCH_AVX512::name();)\
+HAVE_AVX2(case ::SIMD::Arch::AVX2: return ARCH_AVX2::name();)\
+HAVE_SSE4_1(case ::SIMD::Arch::SSE4_1: return ARCH_SSE4_1::name();)\
+HAVE_SIMD(default:)\
+return ARCH_GENERIC::name();\
+HAVE_SIMD(})\
+}
+
 #define DISPATCH_2(ret, name, t1, n1, t2, n2)\
 HAVE_SSE4_1(namespace ARCH_SSE4_1 { ret name(t1 n1, t2 n2); })\
+HAVE_AVX512(namespace ARCH_AVX512 { ret name(t1 n1, t2 n2); })\
 HAVE_AVX2(namespace ARCH_AVX2 { ret name(t1 n1, t2 n2); })\
 HAVE_NEON(namespace ARCH_NEON { ret name(t1 n1, t2 n2); })\
 ret name(t1 n1, t2 n2) {\
 HAVE_SIMD(switch(::SIMD::arch()) {)\
 HAVE_NEON(case ::SIMD::Arch::NEON: return ARCH_NEON::name(n1, n2);)\
+HAVE_AVX512(case ::SIMD::Arch::AVX512: return ARCH_AVX512::name(n1, n2);)\
 HAVE_AVX2(case ::SIMD::Arch::AVX2: return ARCH_AVX2::name(n1, n2);)\
 HAVE_SSE4_1(case ::SIMD::Arch::SSE4_1: return ARCH_SSE4_1::name(n1, n2);)\
 HAVE_SIMD(default:)\
@@ -57,11 +83,13 @@ HAVE_SIMD(})\
 
 #define DISPATCH_3(ret, name, t1, n1, t2, n2, t3, n3)\
 HAVE_SSE4_1(namespace ARCH_SSE4_1 { ret name(t1 n1, t2 n2, t3 n3); })\
+HAVE_AVX512(namespace ARCH_AVX512 { ret name(t1 n1, t2 n2, t3 n3); })\
 HAVE_AVX2(namespace ARCH_AVX2 { ret name(t1 n1, t2 n2, t3 n3); })\
 HAVE_NEON(namespace ARCH_NEON { ret name(t1 n1, t2 n2, t3 n3); })\
 ret name(t1 n1, t2 n2, t3 n3) {\
 HAVE_SIMD(switch(::SIMD::arch()) {)\
 HAVE_NEON(case ::SIMD::Arch::NEON: return ARCH_NEON::name(n1, n2, n3);)\
+HAVE_AVX512(case ::SIMD::Arch::AVX512: return ARCH_AVX512::name(n1, n2, n3);)\
 HAVE_AVX2(case ::SIMD::Arch::AVX2: return ARCH_AVX2::name(n1, n2, n3);)\
 HAVE_SSE4_1(case ::SIMD::Arch::SSE4_1: return ARCH_SSE4_1::name(n1, n2, n3);)\
 HAVE_SIMD(default:)\
@@ -71,11 +99,13 @@ HAVE_SIMD(})\
 
 #define DISPATCH_3V(name, t1, n1, t2, n2, t3, n3)\
 HAVE_SSE4_1(namespace ARCH_SSE4_1 { void name(t1 n1, t2 n2, t3 n3); })\
+HAVE_AVX512(namespace ARCH_AVX512 { void name(t1 n1, t2 n2, t3 n3); })\
 HAVE_AVX2(namespace ARCH_AVX2 { void name(t1 n1, t2 n2, t3 n3); })\
 HAVE_NEON(namespace ARCH_NEON { void name(t1 n1, t2 n2, t3 n3); })\
 void name(t1 n1, t2 n2, t3 n3) {\
 HAVE_SIMD(switch(::SIMD::arch()) {)\
 HAVE_NEON(case ::SIMD::Arch::NEON: ARCH_NEON::name(n1, n2, n3); break;)\
+HAVE_AVX512(case ::SIMD::Arch::AVX512: ARCH_AVX512::name(n1, n2, n3); break;)\
 HAVE_AVX2(case ::SIMD::Arch::AVX2: ARCH_AVX2::name(n1, n2, n3); break;)\
 HAVE_SSE4_1(case ::SIMD::Arch::SSE4_1: ARCH_SSE4_1::name(n1, n2, n3); break;)\
 HAVE_SIMD(default:)\
@@ -85,11 +115,13 @@ HAVE_SIMD(})\
 
 #define DISPATCH_4(ret, name, t1, n1, t2, n2, t3, n3, t4, n4)\
 HAVE_SSE4_1(namespace ARCH_SSE4_1 { ret name(t1 n1, t2 n2, t3 n3, t4 n4); })\
+HAVE_AVX512(namespace ARCH_AVX512 { ret name(t1 n1, t2 n2, t3 n3, t4 n4); })\
 HAVE_AVX2(namespace ARCH_AVX2 { ret name(t1 n1, t2 n2, t3 n3, t4 n4); })\
 HAVE_NEON(namespace ARCH_NEON { ret name(t1 n1, t2 n2, t3 n3, t4 n4); })\
 ret name(t1 n1, t2 n2, t3 n3, t4 n4) {\
 HAVE_SIMD(switch(::SIMD::arch()) {)\
 HAVE_NEON(case ::SIMD::Arch::NEON: return ARCH_NEON::name(n1, n2, n3, n4);)\
+HAVE_AVX512(case ::SIMD::Arch::AVX512: return ARCH_AVX512::name(n1, n2, n3, n4);)\
 HAVE_AVX2(case ::SIMD::Arch::AVX2: return ARCH_AVX2::name(n1, n2, n3, n4);)\
 HAVE_SSE4_1(case ::SIMD::Arch::SSE4_1: return ARCH_SSE4_1::name(n1, n2, n3, n4);)\
 HAVE_SIMD(default:)\
@@ -99,11 +131,13 @@ HAVE_SIMD(})\
 
 #define DISPATCH_5(ret, name, t1, n1, t2, n2, t3, n3, t4, n4, t5, n5)\
 HAVE_SSE4_1(namespace ARCH_SSE4_1 { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5); })\
+HAVE_AVX512(namespace ARCH_AVX512 { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5); })\
 HAVE_AVX2(namespace ARCH_AVX2 { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5); })\
 HAVE_NEON(namespace ARCH_NEON { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5); })\
 ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5) {\
 HAVE_SIMD(switch(::SIMD::arch()) {)\
 HAVE_NEON(case ::SIMD::Arch::NEON: return ARCH_NEON::name(n1, n2, n3, n4, n5);)\
+HAVE_AVX512(case ::SIMD::Arch::AVX512: return ARCH_AVX512::name(n1, n2, n3, n4, n5);)\
 HAVE_AVX2(case ::SIMD::Arch::AVX2: return ARCH_AVX2::name(n1, n2, n3, n4, n5);)\
 HAVE_SSE4_1(case ::SIMD::Arch::SSE4_1: return ARCH_SSE4_1::name(n1, n2, n3, n4, n5);)\
 HAVE_SIMD(default:)\
@@ -113,11 +147,13 @@ HAVE_SIMD(})\
 
 #define DISPATCH_6(ret, name, t1, n1, t2, n2, t3, n3, t4, n4, t5, n5, t6, n6)\
 HAVE_SSE4_1(namespace ARCH_SSE4_1 { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6); })\
+HAVE_AVX512(namespace ARCH_AVX512 { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6); })\
 HAVE_AVX2(namespace ARCH_AVX2 { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6); })\
 HAVE_NEON(namespace ARCH_NEON { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6); })\
 ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6) {\
 HAVE_SIMD(switch(::SIMD::arch()) {)\
 HAVE_NEON(case ::SIMD::Arch::NEON: return ARCH_NEON::name(n1, n2, n3, n4, n5, n6);)\
+HAVE_AVX512(case ::SIMD::Arch::AVX512: return ARCH_AVX512::name(n1, n2, n3, n4, n5, n6);)\
 HAVE_AVX2(case ::SIMD::Arch::AVX2: return ARCH_AVX2::name(n1, n2, n3, n4, n5, n6);)\
 HAVE_SSE4_1(case ::SIMD::Arch::SSE4_1: return ARCH_SSE4_1::name(n1, n2, n3, n4, n5, n6);)\
 HAVE_SIMD(default:)\
@@ -127,11 +163,13 @@ HAVE_SIMD(})\
 
 #define DISPATCH_6V(name, t1, n1, t2, n2, t3, n3, t4, n4, t5, n5, t6, n6)\
 HAVE_SSE4_1(namespace ARCH_SSE4_1 { void name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6); })\
+HAVE_AVX512(namespace ARCH_AVX512 { void name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6); })\
 HAVE_AVX2(namespace ARCH_AVX2 { void name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6); })\
 HAVE_NEON(namespace ARCH_NEON { void name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6); })\
 void name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6) {\
 HAVE_SIMD(switch(::SIMD::arch()) {)\
 HAVE_NEON(case ::SIMD::Arch::NEON: ARCH_NEON::name(n1, n2, n3, n4, n5, n6); break;)\
+HAVE_AVX512(case ::SIMD::Arch::AVX512: ARCH_AVX512::name(n1, n2, n3, n4, n5, n6); break;)\
 HAVE_AVX2(case ::SIMD::Arch::AVX2: ARCH_AVX2::name(n1, n2, n3, n4, n5, n6); break;)\
 HAVE_SSE4_1(case ::SIMD::Arch::SSE4_1: ARCH_SSE4_1::name(n1, n2, n3, n4, n5, n6); break;)\
 HAVE_SIMD(default:)\
@@ -141,11 +179,13 @@ HAVE_SIMD(})\
 
 #define DISPATCH_7(ret, name, t1, n1, t2, n2, t3, n3, t4, n4, t5, n5, t6, n6, t7, n7)\
 HAVE_SSE4_1(namespace ARCH_SSE4_1 { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7); })\
+HAVE_AVX512(namespace ARCH_AVX512 { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7); })\
 HAVE_AVX2(namespace ARCH_AVX2 { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7); })\
 HAVE_NEON(namespace ARCH_NEON { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7); })\
 ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7) {\
 HAVE_SIMD(switch(::SIMD::arch()) {)\
 HAVE_NEON(case ::SIMD::Arch::NEON: return ARCH_NEON::name(n1, n2, n3, n4, n5, n6, n7);)\
+HAVE_AVX512(case ::SIMD::Arch::AVX512: return ARCH_AVX512::name(n1, n2, n3, n4, n5, n6, n7);)\
 HAVE_AVX2(case ::SIMD::Arch::AVX2: return ARCH_AVX2::name(n1, n2, n3, n4, n5, n6, n7);)\
 HAVE_SSE4_1(case ::SIMD::Arch::SSE4_1: return ARCH_SSE4_1::name(n1, n2, n3, n4, n5, n6, n7);)\
 HAVE_SIMD(default:)\
@@ -155,11 +195,13 @@ HAVE_SIMD(})\
 
 #define DISPATCH_7V(name, t1, n1, t2, n2, t3, n3, t4, n4, t5, n5, t6, n6, t7, n7)\
 HAVE_SSE4_1(namespace ARCH_SSE4_1 { void name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7); })\
+HAVE_AVX512(namespace ARCH_AVX512 { void name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7); })\
 HAVE_AVX2(namespace ARCH_AVX2 { void name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7); })\
 HAVE_NEON(namespace ARCH_NEON { void name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7); })\
 void name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7) {\
 HAVE_SIMD(switch(::SIMD::arch()) {)\
 HAVE_NEON(case ::SIMD::Arch::NEON: ARCH_NEON::name(n1, n2, n3, n4, n5, n6, n7); break;)\
+HAVE_AVX512(case ::SIMD::Arch::AVX512: ARCH_AVX512::name(n1, n2, n3, n4, n5, n6, n7); break;)\
 HAVE_AVX2(case ::SIMD::Arch::AVX2: ARCH_AVX2::name(n1, n2, n3, n4, n5, n6, n7); break;)\
 HAVE_SSE4_1(case ::SIMD::Arch::SSE4_1: ARCH_SSE4_1::name(n1, n2, n3, n4, n5, n6, n7); break;)\
 HAVE_SIMD(default:)\
@@ -169,11 +211,13 @@ HAVE_SIMD(})\
 
 #define DISPATCH_8(ret, name, t1, n1, t2, n2, t3, n3, t4, n4, t5, n5, t6, n6, t7, n7, t8, n8)\
 HAVE_SSE4_1(namespace ARCH_SSE4_1 { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7, t8 n8); })\
+HAVE_AVX512(namespace ARCH_AVX512 { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7, t8 n8); })\
 HAVE_AVX2(namespace ARCH_AVX2 { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7, t8 n8); })\
 HAVE_NEON(namespace ARCH_NEON { ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7, t8 n8); })\
 ret name(t1 n1, t2 n2, t3 n3, t4 n4, t5 n5, t6 n6, t7 n7, t8 n8) {\
 HAVE_SIMD(switch(::SIMD::arch()) {)\
 HAVE_NEON(case ::SIMD::Arch::NEON: return ARCH_NEON::name(n1, n2, n3, n4, n5, n6, n7, n8);)\
+HAVE_AVX512(case ::SIMD::Arch::AVX512: return ARCH_AVX512::name(n1, n2, n3, n4, n5, n6, n7, n8);)\
 HAVE_AVX2(case ::SIMD::Arch::AVX2: return ARCH_AVX2::name(n1, n2, n3, n4, n5, n6, n7, n8);)\
 HAVE_SSE4_1(case ::SIMD::Arch::SSE4_1: return ARCH_SSE4_1::name(n1, n2, n3, n4, n5, n6, n7, n8);)\
 HAVE_SIMD(default:)\
@@ -184,6 +228,7 @@ HAVE_SIMD(})\
 #else
 
 #define DISPATCH_0V(name)
+#define DISPATCH_0(ret, name)
 #define DISPATCH_2(ret, name, t1, n1, t2, n2)
 #define DISPATCH_3(ret, name, t1, n1, t2, n2, t3, n3)
 #define DISPATCH_4(ret, name, t1, n1, t2, n2, t3, n3, t4, n4)
@@ -25,10 +25,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "transpose16x16.h"
 #endif
 
-#if ARCH_ID == 2
+#if ARCH_ID == 2 || ARCH_ID == 3
 #include "transpose32x32.h"
 #endif
 
 #if ARCH_ID == 3
-static inline void transpose(const signed char** data, size_t n, signed char* out, const __m512i&) {}
+#include <string.h>
+#include <algorithm>
+
+static inline void transpose(const signed char** data, size_t n, signed char* out, const __m512i&) {
+	alignas(32) signed char buf[32 * 32];
+	const size_t n_hi = std::min(n, (size_t)32), n_lo = n - n_hi;
+	for (ptrdiff_t offset = 0; offset < 2; ++offset) {
+		transpose_offset(data, n_lo, offset, buf, __m256i());
+		for (int i = 0; i < 32; ++i)
+			memcpy(out + (offset * 32 + i) * 64, buf + i * 32, 32);
+		transpose_offset(data + n_lo, n_hi, offset, buf, __m256i());
+		for (int i = 0; i < 32; ++i)
+			memcpy(out + (offset * 32 + i) * 64 + 32, buf + i * 32, 32);
+	}
+}
 #endif
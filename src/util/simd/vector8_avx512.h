@@ -27,7 +27,7 @@ namespace DISPATCH_ARCH { namespace SIMD {
 template<>
 struct Vector<int8_t> {
 
-	static constexpr size_t CHANNELS = 32;
+	static constexpr size_t CHANNELS = 64;
 
 	Vector()
 	{}
@@ -47,20 +47,20 @@ struct Vector<int8_t> {
 template<>
 struct Vector<int16_t> {
 
-	static constexpr size_t CHANNELS = 16;
+	static constexpr size_t CHANNELS = 32;
 
 	Vector()
 	{}
 
 	Vector(const int16_t* p) :
-		v(_mm256_loadu_si256((const __m256i*)p))
+		v(_mm512_loadu_si512((const __m512i*)p))
 	{}
 
-	operator __m256i() const {
+	operator __m512i() const {
 		return v;
 	}
 
-	__m256i v;
+	__m512i v;
 
 };
 
@@ -3,6 +3,8 @@
 #include <stdexcept>
 #include <string.h>
 #include <iostream>
+#include <vector>
+#include <algorithm>
 #include "system.h"
 #include "../string/string.h"
 #include "../log_stream.h"
@@ -16,6 +18,8 @@
   #include <fcntl.h>
   #include <unistd.h>
   #ifndef  __APPLE__
+    #include <sched.h>
+    #include <errno.h>
     #ifdef __FreeBSD__
       #include <sys/types.h>
       #include <sys/sysctl.h>
@@ -198,4 +202,87 @@ size_t l3_cache_size() {
 	const auto s = sysconf(_SC_LEVEL3_CACHE_SIZE);
 	return s == -1 ? 0 : s;
 #endif
-}
\ No newline at end of file
+}
+
+#if defined(_MSC_VER) || defined(__APPLE__) || defined(__FreeBSD__)
+
+int numa_node_count() {
+	return 1;
+}
+
+void set_numa_binding(bool enable) {
+}
+
+void bind_thread(size_t thread_id, size_t thread_count) {
+}
+
+#else
+
+static bool numa_binding = false;
+
+// Reads a list of the form 0-3,8,10-11 as used in /sys/devices/system.
+static std::vector<int> read_cpulist(const std::string& file_name) {
+	std::vector<int> v;
+	FILE* f = fopen(file_name.c_str(), "r");
+	if (!f)
+		return v;
+	int a, b;
+	while (fscanf(f, "%d", &a) == 1) {
+		if (fscanf(f, "-%d", &b) != 1)
+			b = a;
+		for (int i = a; i <= b; ++i)
+			v.push_back(i);
+		if (fgetc(f) != ',')
+			break;
+	}
+	fclose(f);
+	return v;
+}
+
+// The CPUs of each online NUMA node that the process is allowed to run on. Nodes without such CPUs are left out.
+static const std::vector<std::vector<int>>& numa_nodes() {
+	static const std::vector<std::vector<int>> nodes = [] {
+		std::vector<std::vector<int>> v;
+		cpu_set_t allowed;
+		CPU_ZERO(&allowed);
+		if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+			log_stream << "sched_getaffinity failed: " << strerror(errno) << std::endl;
+			return v;
+		}
+		for (int node : read_cpulist("/sys/devices/system/node/online")) {
+			std::vector<int> cpus;
+			for (int cpu : read_cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"))
+				if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))
+					cpus.push_back(cpu);
+			if (!cpus.empty())
+				v.push_back(cpus);
+		}
+		return v;
+	}();
+	return nodes;
+}
+
+int numa_node_count() {
+	return std::max((int)numa_nodes().size(), 1);
+}
+
+void set_numa_binding(bool enable) {
+	numa_binding = enable;
+}
+
+void bind_thread(size_t thread_id, size_t thread_count) {
+	if (!numa_binding)
+		return;
+	const auto& nodes = numa_nodes();
+	if (nodes.size() < 2 || thread_count == 0)
+		return;
+	const size_t node = std::min(thread_id * nodes.size() / thread_count, nodes.size() - 1);
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (int cpu : nodes[node])
+		CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set) != 0)
+		log_stream << "Failed to set the CPU affinity of thread " << thread_id << ": " << strerror(errno) << std::endl;
+}
+
+#endif
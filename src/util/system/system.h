@@ -19,6 +19,9 @@ double total_ram();
 std::tuple<char*, size_t, int> mmap_file(const char* filename);
 void unmap_file(char* ptr, size_t size, int fd);
 size_t l3_cache_size();
+int numa_node_count();
+void set_numa_binding(bool enable);
+void bind_thread(size_t thread_id, size_t thread_count);
 
 #ifdef _MSC_VER
 #define POPEN _popen